@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <iostream>
+
+#define ARENA_LARIAT_CPP
+
+#ifndef ARENA_LARIAT_H
+  #include "arena_lariat.h"
+#endif
+
+template<typename T, usize Size>
+ArenaLariat<T, Size>::ArenaLariat() {
+  reset();
+}
+
+template<typename T, usize Size>
+ArenaLariat<T, Size>::ArenaLariat(const ArenaLariat& rhs):
+    Base{rhs}, arena_{rhs.arena_} {
+  this->base_ = reinterpret_cast<char*>(arena_.data());
+}
+
+template<typename T, usize Size>
+auto ArenaLariat<T, Size>::operator=(const ArenaLariat& rhs)
+  -> ArenaLariat& {
+  if (this != &rhs) {
+    arena_ = rhs.arena_;
+    this->base_ = reinterpret_cast<char*>(arena_.data());
+    this->bytes_ = rhs.bytes_;
+  }
+
+  return *this;
+}
+
+template<typename T, usize Size>
+auto ArenaLariat<T, Size>::save(std::ostream& os) const -> void {
+  os.write(this->base_, static_cast<std::streamsize>(this->bytes_));
+}
+
+template<typename T, usize Size>
+auto ArenaLariat<T, Size>::load(std::istream& is) -> void {
+  try {
+    resize_region(Base::header_bytes);
+    if (not is.read(
+          this->base_,
+          static_cast<std::streamsize>(Base::header_bytes)
+        )) {
+      throw LariatException{
+        LariatException::E_DATA_ERROR,
+        "Lariat image is truncated"
+      };
+    }
+
+    // nothing but the stream bounds the region yet, the header is trusted
+    // for the size of the rest once it is checked
+    this->bytes_ = static_cast<usize>(-1);
+    this->check_header("Lariat image");
+    const usize bytes = Base::header_bytes
+                        + static_cast<usize>(this->header().capacity)
+                            * sizeof(typename Base::Page);
+
+    // the arena only grows as far as the stream delivers, a header claiming
+    // a huge capacity cannot allocate more than one chunk past the real data
+    this->bytes_ = Base::header_bytes;
+    for (usize have = Base::header_bytes; have < bytes;) {
+      const usize chunk = std::min(bytes - have, load_chunk);
+      resize_region(have + chunk);
+      if (not is.read(
+            this->base_ + have,
+            static_cast<std::streamsize>(chunk)
+          )) {
+        throw LariatException{
+          LariatException::E_DATA_ERROR,
+          "Lariat image is truncated"
+        };
+      }
+      have += chunk;
+    }
+
+    this->check_links("Lariat image");
+  } catch (...) {
+    reset();
+    throw;
+  }
+}
+
+template<typename T, usize Size>
+auto ArenaLariat<T, Size>::resize_region(const usize bytes) -> void {
+  arena_.resize((bytes + sizeof(Block) - 1) / sizeof(Block));
+  this->base_ = reinterpret_cast<char*>(arena_.data());
+  this->bytes_ = bytes;
+}
+
+template<typename T, usize Size>
+auto ArenaLariat<T, Size>::reset() -> void {
+  arena_.clear();
+  arena_.shrink_to_fit();
+  resize_region(Base::header_bytes);
+  this->init_header();
+}
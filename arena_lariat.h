@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////
+#ifndef ARENA_LARIAT_H
+#define ARENA_LARIAT_H
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lariat_pages.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Lariat whose nodes live in one growable heap arena
+ *
+ * Nodes are LariatPages pages: links are 32 bit page numbers and the count is
+ * sized to Size, so a node header is a fraction of Lariat's pointer links.
+ * Growing the arena moves it without touching a single link, and the arena is
+ * the same image MappedLariat keeps in its file, so save writes a file that
+ * MappedLariat can open and load reads one back.
+ */
+template<typename T, usize Size>
+class ArenaLariat : public LariatPages<T, Size, ArenaLariat<T, Size>> {
+public:
+
+  /**
+   * @brief Creates an empty list, no pages are allocated until the first
+   * insert
+   */
+  ArenaLariat();
+
+  /**
+   * @brief Copies the arena in one go
+   */
+  ArenaLariat(const ArenaLariat& rhs);
+
+  /**
+   * @brief Copies the arena in one go
+   */
+  auto operator=(const ArenaLariat& rhs) -> ArenaLariat&;
+
+  /**
+   * @brief Writes the arena image (header then every page) to os
+   */
+  auto save(std::ostream& os) const -> void;
+
+  /**
+   * @brief Replaces the contents with an image written by save or a file
+   * created by MappedLariat
+   *
+   * The page links are checked before the image is used and the arena grows
+   * with the bytes actually read, not the capacity the header claims.
+   *
+   * @throws LariatException E_DATA_ERROR if the image is truncated or
+   * malformed (links out of range, cycles, counts that do not add up) or
+   * holds a list of another element type or node size, the list is left
+   * empty
+   */
+  auto load(std::istream& is) -> void;
+
+private:
+
+  using Base = LariatPages<T, Size, ArenaLariat<T, Size>>;
+
+  friend Base;
+
+  /**
+   * @brief Unit of arena storage, aligned for any page
+   */
+  using Block = std::max_align_t;
+
+  static_assert(
+    alignof(typename Base::Page) <= alignof(Block),
+    "ArenaLariat pages must not be over aligned"
+  );
+
+  /**
+   * @brief Most bytes load reads (and grows the arena by) at a time
+   */
+  static constexpr usize load_chunk = usize{1} << 20;
+
+  /**
+   * @brief Resizes the arena to at least bytes, keeping its contents
+   */
+  auto resize_region(usize bytes) -> void;
+
+  /**
+   * @brief Shrinks the arena back to an empty list
+   */
+  auto reset() -> void;
+
+  /**
+   * @brief Backing storage of the region
+   */
+  std::vector<Block> arena_;
+};
+
+#ifndef ARENA_LARIAT_CPP
+  #include "arena_lariat.cpp"
+#endif
+
+#endif // ARENA_LARIAT_H
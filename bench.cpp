@@ -0,0 +1,767 @@
+// Lariat benchmark suite
+//
+// Per-operation microbenchmarks of Lariat against std::vector, std::deque and
+// std::list, swept over node size and element count. Every measurement builds
+// its container outside the timed region, runs warmup repetitions, then
+// reports the median and p99 (nearest rank) time per operation over the timed
+// repetitions using steady_clock.
+//
+// With --trace the suite instead replays a recorded scenario (see scenario.h)
+// against every container, --record writes a seeded default mix to a trace.
+//
+// --cold N adds lookups in a list of N elements whose nodes are scattered in
+// memory, flushing the caches before every repetition, once with the default
+// software prefetching and once without (the _nopf rows).
+//
+// --huge N builds one list of N bytes and times single operations at its far
+// end, N past 2^32 shows the 64-bit index path (about 1.01 bytes per element).
+//
+// usage: bench [--reps N] [--warmup N] [--counts 1000,10000] [--filter text]
+//              [--csv file] [--json file] [--trace file]
+//              [--record file [--ops N] [--seed N]] [--cold N] [--huge N]
+#include "lariat.h"
+#include "scenario.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Keeps the optimizer from discarding a computed value
+ */
+template<typename T>
+auto do_not_optimize(const T& value) -> void {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Deterministic pseudo random positions and values, identical between
+ * runs so results can be diffed
+ */
+class Lcg {
+public:
+
+  explicit Lcg(u64 seed): state_(seed) {}
+
+  auto next() -> u64 {
+    state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+    return state_ >> 33;
+  }
+
+  auto below(usize bound) -> usize {
+    return static_cast<usize>(next() % bound);
+  }
+
+private:
+
+  u64 state_;
+};
+
+struct BenchConfig {
+  int warmup{2};
+  int repetitions{11};
+  std::vector<usize> counts{1000, 10000, 100000};
+  std::string filter{};
+  std::string csv{};
+  std::string json{};
+  std::string trace{};
+  std::string record{};
+  int record_ops{200000};
+  u32 seed{280};
+  usize cold{0};
+  usize huge{0};
+};
+
+/**
+ * @brief Lariat policy with software prefetching turned off
+ */
+struct NoPrefetchPolicy : LariatDefaultPolicy {
+  static constexpr usize prefetch_distance = 0;
+};
+
+struct BenchResult {
+  std::string container;
+  std::string operation;
+  usize node_size;
+  usize elements;
+  usize ops;
+  double median_ns;
+  double p99_ns;
+};
+
+/**
+ * @brief Time per operation of one repetition: setup is not timed, body runs
+ * ops operations on the container setup built
+ */
+template<typename Container, typename Setup, typename Body>
+auto measure_once(Setup& setup, Body& body, usize ops) -> double {
+  Container container;
+  setup(container);
+
+  const auto start = std::chrono::steady_clock::now();
+  body(container);
+  const auto end = std::chrono::steady_clock::now();
+
+  do_not_optimize(container);
+  const std::chrono::duration<double, std::nano> elapsed = end - start;
+  return elapsed.count() / static_cast<double>(ops);
+}
+
+/**
+ * @brief Nearest rank percentile of sorted samples
+ */
+auto percentile(const std::vector<double>& sorted, double p) -> double {
+  const usize rank = static_cast<usize>(
+    p * static_cast<double>(sorted.size()) + 0.999999
+  );
+  return sorted[std::min(sorted.size(), std::max<usize>(rank, 1)) - 1];
+}
+
+/**
+ * @brief Container specific spelling of every benchmarked operation
+ */
+template<typename Container>
+struct Adapter;
+
+template<typename T, usize Size, typename Policy>
+struct Adapter<Lariat<T, Size, Policy>> {
+  using Container = Lariat<T, Size, Policy>;
+
+  static constexpr usize node_size = Size;
+
+  static auto name() -> std::string { return "lariat"; }
+
+  static auto push_back(Container& c, const T& v) -> void { c.push_back(v); }
+
+  static auto push_front(Container& c, const T& v) -> void { c.push_front(v); }
+
+  static auto pop_back(Container& c) -> void { c.pop_back(); }
+
+  static auto pop_front(Container& c) -> void { c.pop_front(); }
+
+  static auto insert(Container& c, usize pos, const T& v) -> void {
+    c.insert(pos, v);
+  }
+
+  static auto erase(Container& c, usize pos) -> void { c.erase(pos); }
+
+  static auto at(const Container& c, usize pos) -> const T& { return c[pos]; }
+
+  static auto find(const Container& c, const T& v) -> usize {
+    return c.find(v);
+  }
+
+  static auto compact(Container& c) -> void { c.compact(); }
+
+  // every push_front into a full head splits it, leaving half full nodes
+  static auto fragment(Container& c, usize elements) -> void {
+    for (usize i = 0; i < elements; i++) {
+      c.push_front(static_cast<T>(i));
+    }
+  }
+
+  static constexpr bool has_compact = true;
+};
+
+template<typename T>
+struct Adapter<std::vector<T>> {
+  using Container = std::vector<T>;
+
+  static constexpr usize node_size = 0;
+
+  static auto name() -> std::string { return "vector"; }
+
+  static auto push_back(Container& c, const T& v) -> void { c.push_back(v); }
+
+  static auto push_front(Container& c, const T& v) -> void {
+    c.insert(c.begin(), v);
+  }
+
+  static auto pop_back(Container& c) -> void { c.pop_back(); }
+
+  static auto pop_front(Container& c) -> void { c.erase(c.begin()); }
+
+  static auto insert(Container& c, usize pos, const T& v) -> void {
+    c.insert(c.begin() + static_cast<std::ptrdiff_t>(pos), v);
+  }
+
+  static auto erase(Container& c, usize pos) -> void {
+    c.erase(c.begin() + static_cast<std::ptrdiff_t>(pos));
+  }
+
+  static auto at(const Container& c, usize pos) -> const T& { return c[pos]; }
+
+  static auto find(const Container& c, const T& v) -> usize {
+    return static_cast<usize>(std::find(c.begin(), c.end(), v) - c.begin());
+  }
+
+  static auto compact(Container& c) -> void { c.shrink_to_fit(); }
+
+  // growth by doubling leaves unused capacity behind
+  static auto fragment(Container& c, usize elements) -> void {
+    for (usize i = 0; i < elements; i++) {
+      c.push_back(static_cast<T>(i));
+    }
+  }
+
+  static constexpr bool has_compact = true;
+};
+
+template<typename T>
+struct Adapter<std::deque<T>> {
+  using Container = std::deque<T>;
+
+  static constexpr usize node_size = 0;
+
+  static auto name() -> std::string { return "deque"; }
+
+  static auto push_back(Container& c, const T& v) -> void { c.push_back(v); }
+
+  static auto push_front(Container& c, const T& v) -> void { c.push_front(v); }
+
+  static auto pop_back(Container& c) -> void { c.pop_back(); }
+
+  static auto pop_front(Container& c) -> void { c.pop_front(); }
+
+  static auto insert(Container& c, usize pos, const T& v) -> void {
+    c.insert(c.begin() + static_cast<std::ptrdiff_t>(pos), v);
+  }
+
+  static auto erase(Container& c, usize pos) -> void {
+    c.erase(c.begin() + static_cast<std::ptrdiff_t>(pos));
+  }
+
+  static auto at(const Container& c, usize pos) -> const T& { return c[pos]; }
+
+  static auto find(const Container& c, const T& v) -> usize {
+    return static_cast<usize>(std::find(c.begin(), c.end(), v) - c.begin());
+  }
+
+  static auto compact(Container& c) -> void { c.shrink_to_fit(); }
+
+  static auto fragment(Container& c, usize elements) -> void {
+    for (usize i = 0; i < elements; i++) {
+      c.push_front(static_cast<T>(i));
+    }
+  }
+
+  static constexpr bool has_compact = true;
+};
+
+template<typename T>
+struct Adapter<std::list<T>> {
+  using Container = std::list<T>;
+
+  static constexpr usize node_size = 0;
+
+  static auto name() -> std::string { return "list"; }
+
+  static auto push_back(Container& c, const T& v) -> void { c.push_back(v); }
+
+  static auto push_front(Container& c, const T& v) -> void { c.push_front(v); }
+
+  static auto pop_back(Container& c) -> void { c.pop_back(); }
+
+  static auto pop_front(Container& c) -> void { c.pop_front(); }
+
+  static auto insert(Container& c, usize pos, const T& v) -> void {
+    c.insert(std::next(c.begin(), static_cast<std::ptrdiff_t>(pos)), v);
+  }
+
+  static auto erase(Container& c, usize pos) -> void {
+    c.erase(std::next(c.begin(), static_cast<std::ptrdiff_t>(pos)));
+  }
+
+  static auto at(const Container& c, usize pos) -> const T& {
+    return *std::next(c.begin(), static_cast<std::ptrdiff_t>(pos));
+  }
+
+  static auto find(const Container& c, const T& v) -> usize {
+    return static_cast<usize>(
+      std::distance(c.begin(), std::find(c.begin(), c.end(), v))
+    );
+  }
+
+  static auto compact(Container&) -> void {}
+
+  static constexpr bool has_compact = false;
+};
+
+class BenchSuite {
+public:
+
+  explicit BenchSuite(const BenchConfig& config): config_(config) {}
+
+  /**
+   * @brief Runs every operation for one container type and element count
+   */
+  template<typename Container>
+  auto run(usize elements) -> void {
+    using A = Adapter<Container>;
+
+    // linear operations on vector/list would dominate the run time, so the
+    // number of operations per repetition is capped
+    const usize ops = std::min<usize>(elements, 1000);
+
+    auto fill = [elements](Container& c) {
+      for (usize i = 0; i < elements; i++) {
+        A::push_back(c, static_cast<int>(i));
+      }
+    };
+
+    add<Container>("push_back", elements, ops, fill, [ops](Container& c) {
+      for (usize i = 0; i < ops; i++) {
+        A::push_back(c, static_cast<int>(i));
+      }
+    });
+
+    add<Container>("push_front", elements, ops, fill, [ops](Container& c) {
+      for (usize i = 0; i < ops; i++) {
+        A::push_front(c, static_cast<int>(i));
+      }
+    });
+
+    add<Container>("pop_back", elements, ops, fill, [ops](Container& c) {
+      for (usize i = 0; i < ops; i++) {
+        A::pop_back(c);
+      }
+    });
+
+    add<Container>("pop_front", elements, ops, fill, [ops](Container& c) {
+      for (usize i = 0; i < ops; i++) {
+        A::pop_front(c);
+      }
+    });
+
+    add<Container>("insert_middle", elements, ops, fill, [=](Container& c) {
+      for (usize i = 0; i < ops; i++) {
+        A::insert(c, (elements + i) / 2, static_cast<int>(i));
+      }
+    });
+
+    add<Container>("erase_middle", elements, ops, fill, [=](Container& c) {
+      for (usize i = 0; i < ops; i++) {
+        A::erase(c, (elements - i) / 2);
+      }
+    });
+
+    add<Container>("index", elements, ops, fill, [=](Container& c) {
+      Lcg lcg{7};
+      long sum = 0;
+      for (usize i = 0; i < ops; i++) {
+        sum += A::at(c, lcg.below(elements));
+      }
+      do_not_optimize(sum);
+    });
+
+    const usize finds = std::min<usize>(ops, 100);
+    add<Container>("find", elements, finds, fill, [=](Container& c) {
+      Lcg lcg{11};
+      usize sum = 0;
+      for (usize i = 0; i < finds; i++) {
+        sum += A::find(c, static_cast<int>(lcg.below(elements)));
+      }
+      do_not_optimize(sum);
+    });
+
+    if constexpr (A::has_compact) {
+      auto fragmented = [elements](Container& c) {
+        A::fragment(c, elements);
+      };
+      add<Container>("compact", elements, 1, fragmented, [](Container& c) {
+        A::compact(c);
+      });
+    }
+
+    add<Container>("copy", elements, 1, fill, [](Container& c) {
+      Container copy(c);
+      do_not_optimize(copy);
+    });
+  }
+
+  /**
+   * @brief Lookups in a list far larger than the caches: filler blocks of
+   * random size between the node allocations keep hardware prefetchers from
+   * guessing the next node
+   */
+  template<typename Container>
+  auto cold(usize elements, const std::string& variant) -> void {
+    using A = Adapter<Container>;
+
+    auto scattered = [this, elements](Container& c) {
+      Lcg lcg{13};
+      filler_.clear();
+      for (usize i = 0; i < elements; i++) {
+        A::push_back(c, static_cast<int>(i));
+        if (i % 8 == 0) {
+          filler_.emplace_back(new char[64 + lcg.below(4096)]);
+        }
+      }
+      flush_caches();
+    };
+
+    const usize finds = 4;
+    add<Container>(
+      "cold_find" + variant,
+      elements,
+      finds,
+      scattered,
+      [](Container& c) {
+        usize sum = 0;
+        for (usize i = 0; i < finds; i++) {
+          sum += A::find(c, -1);
+        }
+        do_not_optimize(sum);
+      }
+    );
+
+    const usize reads = 100;
+    add<Container>(
+      "cold_index" + variant,
+      elements,
+      reads,
+      scattered,
+      [elements](Container& c) {
+        Lcg lcg{7};
+        long sum = 0;
+        for (usize i = 0; i < reads; i++) {
+          sum += A::at(c, lcg.below(elements));
+        }
+        do_not_optimize(sum);
+      }
+    );
+  }
+
+  /**
+   * @brief Builds one list of elements bytes, then times single operations
+   * at its far end, these are the 64-bit index overloads once elements is
+   * past 2^32
+   */
+  auto huge(usize elements) -> void {
+    using Container = Lariat<u8, 4096>;
+
+    Container list;
+    const auto built = time_ns([&] {
+      for (usize i = 0; i < elements; i++) {
+        // 255 is left out for index_of to look for
+        list.push_back(static_cast<u8>(i % 255));
+      }
+    });
+    record("lariat", "huge_build", 4096, elements, elements, built);
+
+    const usize far = elements - elements / 1000 - 1;
+    const auto read = time_ns([&] { do_not_optimize(list[far]); });
+    record("lariat", "huge_index", 4096, elements, 1, read);
+
+    const auto inserted = time_ns([&] { list.insert(far, u8{255}); });
+    record("lariat", "huge_insert", 4096, elements, 1, inserted);
+
+    const auto erased = time_ns([&] { list.erase(far); });
+    record("lariat", "huge_erase", 4096, elements, 1, erased);
+
+    list.push_back(u8{255});
+    usize found{0};
+    const auto scanned = time_ns([&] { found = list.index_of(u8{255}); });
+    record("lariat", "huge_index_of", 4096, elements, 1, scanned);
+
+    if (found != elements or list[found] != u8{255}) {
+      std::cerr << "huge: index_of gave " << found << "\n";
+    }
+  }
+
+  /**
+   * @brief Times a whole recorded scenario on one container type
+   */
+  template<typename Container>
+  auto replay(const LariatScenario& sc) -> void {
+    using A = Adapter<Container>;
+
+    if constexpr (A::has_compact) {
+      const usize ops = std::max<usize>(sc.Get().size(), 1);
+      add<Container>("replay", 0, ops, [](Container&) {}, [&sc](Container& c) {
+        usize sum = 0;
+        for (const auto& op: sc.Get()) {
+          const usize pos = static_cast<usize>(std::get<1>(op));
+          const int val = std::get<2>(op);
+          switch (std::get<0>(op)) {
+            case Insert: A::insert(c, pos, val); break;
+            case Erase: A::erase(c, pos); break;
+            case Pushback: A::push_back(c, val); break;
+            case Pushfront: A::push_front(c, val); break;
+            case Popfront: A::pop_front(c); break;
+            case Popback: A::pop_back(c); break;
+            case Compact: A::compact(c); break;
+            case Index: sum += static_cast<usize>(A::at(c, pos)); break;
+            case Find: sum += A::find(c, val); break;
+          }
+        }
+        do_not_optimize(sum);
+      });
+    }
+  }
+
+  /**
+   * @brief Prints a human readable table
+   */
+  auto print(std::ostream& os) const -> void {
+    os << std::left << std::setw(8) << "type" << std::setw(15) << "operation"
+       << std::right << std::setw(6) << "node" << std::setw(12) << "elements"
+       << std::setw(14) << "median ns/op" << std::setw(14) << "p99 ns/op"
+       << "\n";
+
+    for (const BenchResult& r: results_) {
+      os << std::left << std::setw(8) << r.container << std::setw(15)
+         << r.operation << std::right << std::setw(6) << r.node_size
+         << std::setw(12) << r.elements << std::fixed << std::setprecision(1)
+         << std::setw(14) << r.median_ns << std::setw(14) << r.p99_ns << "\n";
+    }
+  }
+
+  auto write_csv(std::ostream& os) const -> void {
+    os << "container,operation,node_size,elements,ops,median_ns,p99_ns\n";
+    for (const BenchResult& r: results_) {
+      os << r.container << "," << r.operation << "," << r.node_size << ","
+         << r.elements << "," << r.ops << "," << r.median_ns << ","
+         << r.p99_ns << "\n";
+    }
+  }
+
+  auto write_json(std::ostream& os) const -> void {
+    os << "[\n";
+    for (usize i = 0; i < results_.size(); i++) {
+      const BenchResult& r = results_[i];
+      os << "  {\"container\": \"" << r.container << "\", \"operation\": \""
+         << r.operation << "\", \"node_size\": " << r.node_size
+         << ", \"elements\": " << r.elements << ", \"ops\": " << r.ops
+         << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns
+         << "}" << (i + 1 < results_.size() ? "," : "") << "\n";
+    }
+    os << "]\n";
+  }
+
+private:
+
+  template<typename Container, typename Setup, typename Body>
+  auto add(
+    const std::string& operation,
+    usize elements,
+    usize ops,
+    Setup setup,
+    Body body
+  ) -> void {
+    using A = Adapter<Container>;
+
+    const std::string label = A::name() + "/" + operation;
+    if (not config_.filter.empty()
+        and label.find(config_.filter) == std::string::npos) {
+      return;
+    }
+
+    for (int i = 0; i < config_.warmup; i++) {
+      measure_once<Container>(setup, body, ops);
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < config_.repetitions; i++) {
+      samples.push_back(measure_once<Container>(setup, body, ops));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    results_.push_back(BenchResult{
+      A::name(),
+      operation,
+      A::node_size,
+      elements,
+      ops,
+      percentile(samples, 0.5),
+      percentile(samples, 0.99),
+    });
+  }
+
+  /**
+   * @brief Wall time of one call of fn
+   */
+  template<typename Fn>
+  static auto time_ns(Fn&& fn) -> double {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+  }
+
+  /**
+   * @brief Adds a single shot measurement of ops operations to the results
+   */
+  auto record(
+    const std::string& container,
+    const std::string& operation,
+    usize node_size,
+    usize elements,
+    usize ops,
+    double total_ns
+  ) -> void {
+    const double per_op =
+      total_ns / static_cast<double>(std::max<usize>(ops, 1));
+    results_.push_back(BenchResult{
+      container,
+      operation,
+      node_size,
+      elements,
+      ops,
+      per_op,
+      per_op,
+    });
+  }
+
+  /**
+   * @brief Touches a buffer larger than the last level cache
+   */
+  auto flush_caches() -> void {
+    flush_.resize(usize{256} << 20);
+    for (usize i = 0; i < flush_.size(); i += 64) {
+      flush_[i]++;
+    }
+    do_not_optimize(flush_[flush_.size() / 2]);
+  }
+
+  BenchConfig config_;
+  std::vector<BenchResult> results_{};
+
+  // allocations interleaved with the nodes of the cold lists
+  std::vector<std::unique_ptr<char[]>> filler_{};
+
+  std::vector<char> flush_{};
+};
+
+auto parse_counts(const std::string& list) -> std::vector<usize> {
+  std::vector<usize> counts;
+  std::stringstream ss(list);
+  for (std::string item; std::getline(ss, item, ',');) {
+    counts.push_back(static_cast<usize>(std::stoull(item)));
+  }
+  return counts;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  BenchConfig config;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+
+    if (arg == "--reps" and has_value) {
+      config.repetitions = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--warmup" and has_value) {
+      config.warmup = std::max(0, std::stoi(argv[++i]));
+    } else if (arg == "--counts" and has_value) {
+      config.counts = parse_counts(argv[++i]);
+    } else if (arg == "--filter" and has_value) {
+      config.filter = argv[++i];
+    } else if (arg == "--csv" and has_value) {
+      config.csv = argv[++i];
+    } else if (arg == "--json" and has_value) {
+      config.json = argv[++i];
+    } else if (arg == "--trace" and has_value) {
+      config.trace = argv[++i];
+    } else if (arg == "--record" and has_value) {
+      config.record = argv[++i];
+    } else if (arg == "--ops" and has_value) {
+      config.record_ops = std::max(0, std::stoi(argv[++i]));
+    } else if (arg == "--seed" and has_value) {
+      config.seed = static_cast<u32>(std::stoul(argv[++i]));
+    } else if (arg == "--cold" and has_value) {
+      config.cold = static_cast<usize>(std::stoull(argv[++i]));
+    } else if (arg == "--huge" and has_value) {
+      config.huge = static_cast<usize>(std::stoull(argv[++i]));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--reps N] [--warmup N] [--counts 1000,10000]"
+                   " [--filter text] [--csv file] [--json file]"
+                   " [--trace file] [--record file [--ops N] [--seed N]]"
+                   " [--cold N] [--huge N]\n";
+      return 1;
+    }
+  }
+
+  if (not config.record.empty()) {
+    // same mix as the driver's timing scenario
+    const LariatScenario sc(
+      config.record_ops,
+      200000,
+      2,
+      1,
+      1,
+      1,
+      1,
+      1,
+      1,
+      1,
+      1,
+      config.seed
+    );
+    std::ofstream trace(config.record, std::ios::binary);
+    sc.WriteTrace(trace);
+    return 0;
+  }
+
+  BenchSuite suite(config);
+
+  if (not config.trace.empty()) {
+    std::ifstream trace(config.trace, std::ios::binary);
+    const LariatScenario sc(trace);
+    suite.replay<Lariat<int, 16>>(sc);
+    suite.replay<Lariat<int, 64>>(sc);
+    suite.replay<Lariat<int, 256>>(sc);
+    suite.replay<Lariat<int, 1024>>(sc);
+    suite.replay<std::vector<int>>(sc);
+    suite.replay<std::deque<int>>(sc);
+  } else {
+    for (const usize elements: config.counts) {
+      suite.run<Lariat<int, 16>>(elements);
+      suite.run<Lariat<int, 64>>(elements);
+      suite.run<Lariat<int, 256>>(elements);
+      suite.run<Lariat<int, 1024>>(elements);
+      suite.run<std::vector<int>>(elements);
+      suite.run<std::deque<int>>(elements);
+      suite.run<std::list<int>>(elements);
+    }
+  }
+
+  if (config.cold > 0) {
+    suite.cold<Lariat<int, 16>>(config.cold, "");
+    suite.cold<Lariat<int, 16, NoPrefetchPolicy>>(config.cold, "_nopf");
+    suite.cold<Lariat<int, 256>>(config.cold, "");
+    suite.cold<Lariat<int, 256, NoPrefetchPolicy>>(config.cold, "_nopf");
+  }
+
+  if (config.huge > 0) {
+    suite.huge(config.huge);
+  }
+
+  suite.print(std::cout);
+
+  if (not config.csv.empty()) {
+    std::ofstream csv(config.csv);
+    suite.write_csv(csv);
+  }
+
+  if (not config.json.empty()) {
+    std::ofstream json(config.json);
+    suite.write_json(json);
+  }
+
+  return 0;
+}
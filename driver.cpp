@@ -7,6 +7,9 @@
 #include <algorithm>  // std::max_element
 #include <functional> // std::bind std::placeholders
 #include "lariat.cpp"
+#include "mapped_lariat.h"
+#include "arena_lariat.h"
+#include "lariat_text.h"
 #include <algorithm>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -462,351 +465,7 @@ void test22() // assignment - different instantiations
 }
 
 // stress testing
-#include <tuple>
-#include <map>
-#include <vector>
-
-enum Action {
-  Insert,
-  Pushback,
-  Pushfront,
-  Compact,
-  Erase,
-  Popback,
-  Popfront,
-  Index,
-  Find
-};
-
-//            <------- always OK ---------------->  <-- when non-empty ---->
-
-#include <random>
-
-class RouletteWheel {
-public:
-
-  RouletteWheel() = delete;
-  RouletteWheel(const RouletteWheel&) = delete;
-  RouletteWheel(RouletteWheel&&) = delete;
-  RouletteWheel& operator=(const RouletteWheel&) = delete;
-  RouletteWheel& operator=(RouletteWheel&&) = delete;
-  ~RouletteWheel() = default;
-
-  RouletteWheel(const std::multimap<float, Action>& _p, float _from, float _to):
-      p(_p), gen(rd()), dis(_from, _to) {
-    for (const auto& el: p) {
-      // std::cout << el.first << " --> " << el.second << std::endl;
-      v.push_back(std::tuple<float, Action>(el.first, el.second));
-    }
-    // std::cout << "upper limit " << _to << std::endl;
-  }
-
-  Action Spin() {
-    return p.upper_bound(dis(gen))->second; // find key of the first element of
-                                            // the map that is >= rand_value
-  }
-
-private:
-
-  std::vector<std::tuple<float, Action>> v;
-  const std::multimap<float, Action>& p;
-  std::random_device rd;
-  std::mt19937 gen;
-  std::uniform_real_distribution<float> dis;
-};
-
-class RandomNumber {
-public:
-
-  RandomNumber() = delete;
-  RandomNumber(const RandomNumber&) = delete;
-  RandomNumber(RandomNumber&&) = delete;
-  RandomNumber& operator=(const RandomNumber&) = delete;
-  RandomNumber& operator=(RandomNumber&&) = delete;
-  ~RandomNumber() = default;
-
-  RandomNumber(int _from, int _to): gen(rd()), dis(_from, _to) {}
-
-  int GetInt(int max) {
-    int rand_value = dis(gen);
-    return rand_value % (max); // returns 0..max-1 inclusively
-  }
-
-private:
-
-  std::random_device rd;
-  std::mt19937 gen;
-  std::uniform_int_distribution<> dis;
-};
-
-class LariatScenario {
-public:
-
-  LariatScenario() = delete;
-  LariatScenario(const LariatScenario&) = delete;
-  LariatScenario(LariatScenario&&) = delete;
-  LariatScenario& operator=(const LariatScenario&) = delete;
-  LariatScenario& operator=(LariatScenario&&) = delete;
-  ~LariatScenario() = default;
-
-  LariatScenario(
-    int num_operations,
-    int max_value,
-    float insertF,
-    float eraseF,     // relative frequences of the 9 operations
-    float pushbackF,
-    float pushfrontF, // do not have to add up to 1
-    float popbackF,
-    float popfrontF,  // normalized by hand
-    float compactF,
-    float indexF,
-    float findF
-  ) {
-    int current_size =
-      0; // need to know whether delete-like operations are allowed
-
-    std::multimap<float, Action> probabilities;
-    float TotalF = insertF + eraseF + pushbackF + pushfrontF + popbackF
-                 + popfrontF + compactF + indexF + findF;
-
-    //            probabilities[(insertF + pushbackF + pushfrontF + compactF +
-    //            eraseF + popbackF + popfrontF + indexF + findF) / TotalF ] =
-    //            Find; probabilities[(insertF + pushbackF + pushfrontF +
-    //            compactF + eraseF + popbackF + popfrontF + indexF ) / TotalF
-    //            ]    =  Index; probabilities[(insertF + pushbackF + pushfrontF
-    //            + compactF + eraseF + popbackF + popfrontF) / TotalF ]    =
-    //            Popfront; probabilities[(insertF + pushbackF + pushfrontF +
-    //            compactF + eraseF + popbackF ) / TotalF ]    =  Popback;
-    //            probabilities[(insertF + pushbackF + pushfrontF + compactF +
-    //            eraseF) / TotalF                                         ] =
-    //            Erase; probabilities[(insertF + pushbackF + pushfrontF +
-    //            compactF) / TotalF ]    =  Compact; probabilities[(insertF +
-    //            pushbackF + pushfrontF) / TotalF ]    =  Pushfront;
-    //            probabilities[(insertF + pushbackF) / TotalF ]    =  Pushback;
-    //            probabilities[ insertF / TotalF ]    =  Insert;
-    probabilities.insert(std::make_pair(
-      (insertF + pushbackF + pushfrontF + compactF + eraseF + popbackF
-       + popfrontF + indexF + findF)
-        / TotalF,
-      Find
-    ));
-    probabilities.insert(std::make_pair(
-      (insertF + pushbackF + pushfrontF + compactF + eraseF + popbackF
-       + popfrontF + indexF)
-        / TotalF,
-      Index
-    ));
-    probabilities.insert(std::make_pair(
-      (insertF + pushbackF + pushfrontF + compactF + eraseF + popbackF
-       + popfrontF)
-        / TotalF,
-      Popfront
-    ));
-    probabilities.insert(std::make_pair(
-      (insertF + pushbackF + pushfrontF + compactF + eraseF + popbackF)
-        / TotalF,
-      Popback
-    ));
-    probabilities.insert(std::make_pair(
-      (insertF + pushbackF + pushfrontF + compactF + eraseF) / TotalF,
-      Erase
-    ));
-    probabilities.insert(std::make_pair(
-      (insertF + pushbackF + pushfrontF + compactF) / TotalF,
-      Compact
-    ));
-    probabilities.insert(
-      std::make_pair((insertF + pushbackF + pushfrontF) / TotalF, Pushfront)
-    );
-    probabilities.insert(
-      std::make_pair((insertF + pushbackF) / TotalF, Pushback)
-    );
-    probabilities.insert(std::make_pair(insertF / TotalF, Insert));
-
-    RouletteWheel rw_all(
-      probabilities,
-      0,
-      1
-    ); // roulette wheel with required frequencies for all actions
-    float upper_limit_for_empty = (insertF + pushbackF + pushfrontF + compactF)
-                                / TotalF; // use instead of 1 if empty
-    RouletteWheel rw_insert(
-      probabilities,
-      0,
-      upper_limit_for_empty
-    ); // roulette wheel with required frequencies for insert-like actions
-
-    RandomNumber rn(
-      0,
-      num_operations * num_operations
-    ); // num_operations is more or less magic number in this context
-
-    for (int i = 0; i < num_operations; ++i) {
-      Action action;
-      if (current_size == 0) { // only insert, pushes, compact are allowed
-        action = rw_insert.Spin();
-      } else {
-        action = rw_all.Spin();
-      }
-
-      if (action == Insert) { // insert is legal at indicies 0..current_size
-                              // inclusively
-        scenario.push_back(std::tuple<Action, int, int>(
-          action,
-          rn.GetInt(current_size + 1),
-          rn.GetInt(max_value)
-        ));
-        ++current_size;
-      } else if (action == Erase) { // erase is legal at indicies
-                                    // 0..current_size-1 inclusively
-        scenario.push_back(
-          std::tuple<Action, int, int>(action, rn.GetInt(current_size), 0)
-        ); // value not used by operation
-        --current_size;
-      } else if (action == Pushfront || action == Pushback) {
-        scenario.push_back(
-          std::tuple<Action, int, int>(action, 0, rn.GetInt(100))
-        ); // position not used by operation
-        ++current_size;
-      } else if (action == Popfront || action == Popback) {
-        scenario.push_back(std::tuple<Action, int, int>(action, 0, 0)
-        ); // position and value not used by operation
-        --current_size;
-      } else if (action == Compact) {
-        scenario.push_back(std::tuple<Action, int, int>(action, 0, 0)
-        ); // position and value not used by operation
-      } else if (action == Find) {
-        scenario.push_back(
-          std::tuple<Action, int, int>(action, 0, rn.GetInt(100))
-        ); // value
-      } else if (action == Index) {
-        scenario.push_back(
-          std::tuple<Action, int, int>(action, rn.GetInt(current_size), 0)
-        ); // position
-      } else {
-        std::cout << "illegal operation\n";
-      }
-    }
-  }
-
-  friend std::ostream& operator<<(std::ostream& os, const LariatScenario& sc) {
-    for (const auto& op: sc.Get()) {
-      int val = std::get<2>(op);
-      int pos = std::get<1>(op);
-      Action a = std::get<0>(op);
-      switch (a) { // use labels
-        case Insert: os << "Insert"; break;
-        case Erase: os << "Erase"; break;
-        case Pushback: os << "Pushback"; break;
-        case Pushfront: os << "Pushfront"; break;
-        case Popfront: os << "Popfront"; break;
-        case Popback: os << "Popback"; break;
-        case Compact: os << "Compact"; break;
-        case Index: os << "Index"; break;
-        case Find: os << "Find"; break;
-      }
-      os << " " << pos << " " << val << std::endl;
-    }
-    return os;
-  }
-
-  friend std::istream& operator>>(std::istream& is, LariatScenario& sc) {
-    sc.scenario.erase(sc.scenario.begin(), sc.scenario.end());
-    for (std::string a_str; is >> a_str;) {
-      int pos = 0, val = 0;
-      Action a;
-      if (a_str == "Insert") {
-        a = Insert;
-        is >> pos >> val;
-      } else if (a_str == "Erase") {
-        a = Erase;
-        is >> pos;
-      } else if (a_str == "Pushback") {
-        a = Pushback;
-        is >> val;
-      } else if (a_str == "Pushfront") {
-        a = Pushfront;
-        is >> val;
-      } else if (a_str == "Popfront") {
-        a = Popfront;
-      } else if (a_str == "Popback") {
-        a = Popback;
-      } else if (a_str == "Compact") {
-        a = Compact;
-      } else if (a_str == "Index") {
-        a = Index;
-        is >> pos;
-      } else if (a_str == "Find") {
-        a = Find;
-        is >> val;
-      } else {
-        // add NOOP?
-      }
-      sc.scenario.push_back(std::tuple<Action, int, int>(a, pos, val));
-    }
-    return is;
-  }
-
-  ////////////////////////////////////////////////////
-  const std::vector<std::tuple<Action, int, int>>& Get() const {
-    return scenario;
-  }
-
-  void DrawStats(std::map<Action, std::string>& labels
-  ) const // reference should be const, but std::map[] is complaining
-  {
-    // final frequencies
-    std::map<Action, float> counts;
-    for (const auto& op: scenario) {
-      Action a = std::get<0>(op);
-      counts[a] += 1.0f;
-    }
-
-    // normalization - longest label
-    unsigned max_len = 0;
-    for (const auto& lbl: labels) {
-      if (lbl.second.length() > max_len) {
-        max_len = static_cast<unsigned>(lbl.second.length());
-      }
-    }
-
-    // normalization 80 symbols
-    float max_freq = std::max_element(
-                       counts.begin(),
-                       counts.end(),
-                       std::bind(
-                         std::less<float>(),
-                         bind(
-                           &std::map<Action, float>::value_type::second,
-                           std::placeholders::_1
-                         ),
-                         bind(
-                           &std::map<Action, float>::value_type::second,
-                           std::placeholders::_2
-                         )
-                       )
-    )
-                       ->second;
-
-    max_len += 1; // bar offset
-    // print
-    std::cout << "Statistics\n";
-    for (const auto& el: counts) {
-      std::cout << std::left << std::setw(static_cast<int>(max_len))
-                << labels[el.first] << std::setfill('+')
-                << std::setw(static_cast<int>(
-                     el.second / max_freq * static_cast<float>(79 - max_len)
-                   ))
-                << "+" << std::setfill(' ')
-                << std::endl; // should have saved fill from before and set it
-                              // back, assume 'space'
-    }
-  }
-
-private:
-
-  std::vector<std::tuple<Action, int, int>> scenario; // action, position, value
-};
+#include "scenario.h"
 
 template<int nodesize>
 void run_scenario_with_alotof_output // for debugging
@@ -894,34 +553,14 @@ void run_scenario_with_alotof_output // for debugging
   // sc.DrawStats( labels );
 }
 
-template<int nodesize>
-void run_scenario_cmp_to_vector // for correctess
-  (int num_operations,
-   float insertF,
-   float eraseF,     // relative frequences of the 9 operations
-   float pushbackF,
-   float pushfrontF, // do not have to add up to 1
-   float popbackF,
-   float popfrontF,  // normalized by hand
-   float compactF,
-   float indexF,
-   float findF) {
-  LariatScenario sc(
-    num_operations,
-    2000,
-    insertF,
-    eraseF,
-    pushbackF,
-    pushfrontF,
-    popbackF,
-    popfrontF,
-    compactF,
-    indexF,
-    findF
-  );
-  // std::cout << sc;
-
-  Lariat<int, nodesize> lar;
+template<int nodesize, typename Policy = LariatDefaultPolicy>
+void replay_cmp_to_vector // for correctess
+  (const LariatScenario& sc,
+   bool indexed = false) { // serve find from the value index
+  Lariat<int, nodesize, Policy> lar;
+  if (indexed) {
+    lar.enable_index();
+  }
   std::vector<int> v;
   for (const auto& op: sc.Get()) {
     int val = std::get<2>(op);
@@ -1005,6 +644,36 @@ void run_scenario_cmp_to_vector // for correctess
 
 #include <chrono>
 
+template<int nodesize>
+void run_scenario_cmp_to_vector // for correctess
+  (int num_operations,
+   float insertF,
+   float eraseF,     // relative frequences of the 9 operations
+   float pushbackF,
+   float pushfrontF, // do not have to add up to 1
+   float popbackF,
+   float popfrontF,  // normalized by hand
+   float compactF,
+   float indexF,
+   float findF,
+   bool indexed = false) { // serve find from the value index
+  LariatScenario sc(
+    num_operations,
+    2000,
+    insertF,
+    eraseF,
+    pushbackF,
+    pushfrontF,
+    popbackF,
+    popfrontF,
+    compactF,
+    indexF,
+    findF
+  );
+  // std::cout << sc;
+  replay_cmp_to_vector<nodesize>(sc, indexed);
+}
+
 template<int nodesize>
 void run_scenario_cmp_to_vector_time // optimizations
   (int num_operations,
@@ -1028,11 +697,13 @@ void run_scenario_cmp_to_vector_time // optimizations
     popfrontF,
     compactF,
     indexF,
-    findF
+    findF,
+    280 // fixed seed, every run times the same operations
   );
 
-  std::chrono::time_point<std::chrono::system_clock> start =
-    std::chrono::system_clock::now();
+  // single shot sanity timing, see bench.cpp for repeated measurements
+  std::chrono::time_point<std::chrono::steady_clock> start =
+    std::chrono::steady_clock::now();
   Lariat<int, nodesize> lar;
   for (const auto& op: sc.Get()) {
     int val = std::get<2>(op);
@@ -1050,12 +721,12 @@ void run_scenario_cmp_to_vector_time // optimizations
       case Find: lar.find(val); break;
     }
   }
-  std::chrono::time_point<std::chrono::system_clock> end =
-    std::chrono::system_clock::now();
+  std::chrono::time_point<std::chrono::steady_clock> end =
+    std::chrono::steady_clock::now();
   std::chrono::duration<double> elapsed_seconds = end - start;
   std::cout << "Lariat: time elapsed " << elapsed_seconds.count() << std::endl;
 
-  start = std::chrono::system_clock::now();
+  start = std::chrono::steady_clock::now();
   std::vector<int> v;
   for (const auto& op: sc.Get()) {
     int val = std::get<2>(op);
@@ -1073,7 +744,7 @@ void run_scenario_cmp_to_vector_time // optimizations
       case Find: std::find(v.begin(), v.end(), val); break;
     }
   }
-  end = std::chrono::system_clock::now();
+  end = std::chrono::steady_clock::now();
   elapsed_seconds = end - start;
   std::cout << "Vector: time elapsed " << elapsed_seconds.count() << std::endl;
 
@@ -1185,10 +856,1724 @@ void test26() {
   );
 }
 
+void test27() {
+  std::cout << "-------- " << __func__ << " --------\n";
+  // this is random scenario
+  // expected output - NONE
+  // find served by the value index, many duplicate values
+  run_scenario_cmp_to_vector<10>( // node size
+    4000,                         // num operations
+    4,
+    2,                            // insert, erase
+    4,
+    2,                            // pushfront, pushback
+    1,
+    1,                            // popfront, popback
+    1,                            // compact
+    1,                            // index
+    4,                            // find
+    true                          // indexed
+  );
+}
+
+void test28() // value index vs linear scan - memory and latency
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  // expected output - time and memory, not used in grading
+  const int count = 1 << 18;
+  const int lookups = 1 << 12;
+  Lariat<int, 64> lar;
+  for (int i = 0; i < count; ++i) {
+    lar.push_back((i * 7919) % (count / 2)); // every value twice
+  }
+
+  auto time_finds = [&]() {
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    unsigned checksum = 0;
+    for (int i = 0; i < lookups; ++i) {
+      checksum += lar.find((i * 104729) % count); // half of them miss
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+    return std::make_pair(elapsed.count() / lookups, checksum);
+  };
+
+  const auto [scan_us, scan_sum] = time_finds();
+  lar.enable_index();
+  const auto [index_us, index_sum] = time_finds();
+
+  if (scan_sum != index_sum) {
+    std::cout << "Index and scan disagree\n";
+  }
+  std::cout << "Elements     : " << lar.size() << std::endl;
+  std::cout << "List bytes   : " << lar.size() * sizeof(int) << std::endl;
+  std::cout << "Index bytes  : " << lar.index_memory() << std::endl;
+  std::cout << "Scan  find us: " << scan_us << std::endl;
+  std::cout << "Index find us: " << index_us << std::endl;
+
+  // upkeep per insert + erase, values stored once against values stored
+  // twice, whose first occurrences move (see enable_index)
+  const auto time_edits = [&](bool indexed, int distinct) {
+    Lariat<int, 64> edited;
+    for (int i = 0; i < count / 4; ++i) {
+      edited.push_back((i * 7919) % distinct);
+    }
+    if (indexed) {
+      edited.enable_index();
+    }
+
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+      const int at = (i * 104729) % static_cast<int>(edited.size());
+      edited.insert(at, (i * 7919) % distinct);
+      edited.erase((at * 31) % static_cast<int>(edited.size()));
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+    return elapsed.count() / lookups;
+  };
+
+  std::cout << "Scan  edit us: " << time_edits(false, count / 4) << std::endl;
+  std::cout << "Index edit us: " << time_edits(true, count / 4)
+            << " (distinct)" << std::endl;
+  std::cout << "Index edit us: " << time_edits(true, count / 8)
+            << " (every value twice)" << std::endl;
+}
+
+#include <sstream>
+
+void test29() // binary snapshot save/load
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 7;
+  Lariat<int, asize> lar;
+  for (int i = 0; i < 40; ++i) {
+    lar.insert(i / 2, i + 1);
+  }
+  lar.erase(5);
+  lar.pop_front();
+
+  std::stringstream snapshot;
+  lar.save(snapshot);
+  std::cout << "Snapshot bytes = " << snapshot.str().size() << std::endl;
+
+  // same node size, layout is preserved
+  Lariat<int, asize> same;
+  same.load(snapshot);
+  std::ostringstream before, after;
+  before << lar;
+  after << same;
+  std::cout << "Same size layout "
+            << (before.str() == after.str() ? "matches" : "differs")
+            << std::endl;
+
+  // smaller nodes, blocks are spread out
+  snapshot.seekg(0);
+  Lariat<int, 3> smaller;
+  smaller.load(snapshot);
+  for (unsigned i = 0; i < lar.size(); ++i) {
+    if (lar[i] != smaller[i]) {
+      std::cout << "Load into smaller nodes failed at " << i << std::endl;
+    }
+  }
+  std::cout << "Size = " << smaller.size() << std::endl;
+
+  // wrong element type
+  snapshot.seekg(0);
+  Lariat<float, asize> other_type;
+  try {
+    other_type.load(snapshot);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+
+  // truncated snapshot leaves the list empty
+  std::string bytes = snapshot.str();
+  std::istringstream truncated(bytes.substr(0, bytes.size() - 3));
+  try {
+    same.load(truncated);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  std::cout << "Size = " << same.size() << std::endl;
+}
+
+#include <filesystem>
+#include <fstream>
+
+void test30() // memory mapped lariat
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "lariat_test30.map").string();
+  std::filesystem::remove(path);
+
+  std::vector<int> v;
+  {
+    MappedLariat<int, 5> lar(path);
+    for (int i = 0; i < 60; ++i) {
+      const int pos = (i * 7) % (static_cast<int>(v.size()) + 1);
+      lar.insert(pos, i);
+      v.insert(v.begin() + pos, i);
+    }
+    for (int i = 0; i < 20; ++i) {
+      const int pos = (i * 11) % static_cast<int>(v.size());
+      lar.erase(pos);
+      v.erase(v.begin() + pos);
+    }
+    lar.sync();
+    std::cout << "Size = " << lar.size() << " nodes = " << lar.node_count()
+              << std::endl;
+  }
+
+  // reopening maps the same pages, nothing is deserialized
+  MappedLariat<int, 5> lar(path);
+  for (unsigned i = 0; i < v.size(); ++i) {
+    if (lar[static_cast<int>(i)] != v[i]) {
+      std::cout << "values differ at " << i << std::endl;
+    }
+  }
+
+  lar.compact();
+  std::cout << "After compacting nodes = " << lar.node_count()
+            << " pages = " << lar.page_capacity() << std::endl;
+
+  // released pages are reused before the file grows
+  for (int i = 0; i < 10; ++i) {
+    lar.push_front(100 + i);
+  }
+  std::cout << "After pushing pages = " << lar.page_capacity() << std::endl;
+  std::cout << "find 105: " << lar.find(105) << std::endl;
+
+  usize total = 0;
+  lar.for_each_chunk([&total](LariatSpan<const int> chunk) {
+    total += chunk.size();
+  });
+  std::cout << "Chunked size = " << total << std::endl;
+
+  lar.close();
+  std::cout << "closed: [" << lar << "]" << std::endl;
+  try {
+    MappedLariat<int, 6> wrong(path);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: wrong node size" << std::endl;
+  }
+
+  // a damaged head link is caught when the file is opened, not followed
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    const u32 head = 0x7FFFFFFF;
+    file.seekp(64); // RegionHeader::head
+    file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+  }
+  try {
+    MappedLariat<int, 5> damaged(path);
+    std::cout << "damaged[0] = " << damaged[0] << std::endl;
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: damaged head" << std::endl;
+  }
+  std::filesystem::remove(path);
+}
+
+void test31() // operation counters and occupancy
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 8;
+  Lariat<int, asize, LariatStatsPolicy> lar;
+  for (int i = 0; i < 100; ++i) {
+    lar.insert(i / 3, i);
+  }
+  for (int i = 0; i < 30; ++i) {
+    lar.erase(i);
+  }
+  for (int i = 0; i < 50; i += 5) {
+    (void)lar[i];
+  }
+
+  const LariatStatsReport report = lar.stats();
+  std::cout << "splits " << report.counters.splits << std::endl;
+  std::cout << "nodes " << report.nodes << " ideal " << report.ideal_nodes
+            << std::endl;
+  report.write_json(std::cout);
+  std::cout << std::endl;
+
+  lar.compact();
+  lar.reset_stats();
+  lar.stats().write_json(std::cout);
+  std::cout << std::endl;
+
+  // default policy keeps no counters
+  Lariat<int, asize> plain(lar);
+  std::cout << "counting " << plain.stats().counting << std::endl;
+}
+
+void test32() // seeded scenarios and binary traces
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  // same seed, same operations
+  LariatScenario sc(12, 50, 2, 1, 1, 1, 1, 1, 1, 1, 1, 280);
+  LariatScenario again(12, 50, 2, 1, 1, 1, 1, 1, 1, 1, 1, 280);
+  std::cout << sc;
+  std::cout << "Same seed "
+            << (sc.Get() == again.Get() ? "matches" : "differs") << std::endl;
+
+  // record, replay
+  LariatScenario big(300, 2000, 4, 1, 4, 2, 1, 1, 1, 1, 1, 7);
+  std::stringstream trace;
+  big.WriteTrace(trace);
+  std::cout << "Trace bytes = " << trace.str().size() << std::endl;
+
+  LariatScenario replayed(trace);
+  std::cout << "Replayed trace "
+            << (replayed.Get() == big.Get() ? "matches" : "differs")
+            << " seed " << replayed.Seed() << std::endl;
+
+  std::istringstream garbage("not a trace");
+  try {
+    replayed.ReadTrace(garbage);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+}
+
+struct GapStatsPolicy : LariatGapPolicy {
+  using Stats = LariatCountingStats;
+};
+
+void test33() // gap buffer nodes
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 64;
+
+  // typing at a cursor that jumps now and then
+  Lariat<int, asize, LariatStatsPolicy> window;
+  Lariat<int, asize, GapStatsPolicy> gap;
+  std::vector<int> v;
+  for (int burst = 0; burst < 20; ++burst) {
+    int cursor = (burst * 37) % (static_cast<int>(v.size()) + 1);
+    for (int i = 0; i < 30; ++i, ++cursor) {
+      window.insert(cursor, i);
+      gap.insert(cursor, i);
+      v.insert(v.begin() + cursor, i);
+    }
+    for (int i = 0; i < 5; ++i) { // backspace
+      --cursor;
+      window.erase(cursor);
+      gap.erase(cursor);
+      v.erase(v.begin() + cursor);
+    }
+  }
+
+  bool same = window.size() == v.size() and gap.size() == v.size();
+  for (unsigned i = 0; same and i < v.size(); ++i) {
+    same = window[i] == v[i] and gap[i] == v[i];
+  }
+  std::cout << "Size = " << gap.size() << (same ? " matches" : " differs")
+            << std::endl;
+  std::cout << "window shifted " << window.stats().counters.shifted_elements
+            << std::endl;
+  std::cout << "gap shifted    " << gap.stats().counters.shifted_elements
+            << std::endl;
+
+  // snapshot and compact see the items in order
+  std::stringstream snapshot;
+  gap.save(snapshot);
+  Lariat<int, 10> loaded;
+  loaded.load(snapshot);
+  gap.compact();
+  same = loaded.size() == v.size() and gap.size() == v.size();
+  for (unsigned i = 0; same and i < v.size(); ++i) {
+    same = loaded[i] == v[i] and gap[i] == v[i];
+  }
+  std::cout << "Snapshot and compact " << (same ? "match" : "differ")
+            << std::endl;
+
+  // random operations against vector
+  LariatScenario sc(400, 2000, 4, 1, 4, 2, 1, 1, 1, 1, 1, 33);
+  replay_cmp_to_vector<10, LariatGapPolicy>(sc);
+  replay_cmp_to_vector<10, LariatGapPolicy>(sc, true);
+}
+
+struct InlineStatsPolicy : LariatInlinePolicy {
+  using Stats = LariatCountingStats;
+};
+
+void test34() // inline first node and move semantics
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 4;
+
+  // short lists never leave the object
+  using Tiny = Lariat<int, asize, InlineStatsPolicy>;
+  u64 allocations = 0;
+  for (int i = 0; i < 1000; ++i) {
+    Tiny tiny;
+    tiny.push_back(i);
+    tiny.push_front(i + 1);
+    Tiny copy(tiny);
+    copy.pop_back();
+    allocations += tiny.stats().counters.allocations;
+    allocations += copy.stats().counters.allocations;
+  }
+  std::cout << "Tiny list allocations = " << allocations << std::endl;
+
+  // the inline node spills over into heap nodes
+  Tiny lar;
+  for (int i = 0; i < 10; ++i) {
+    lar.insert(i / 2, i);
+  }
+  std::cout << lar;
+
+  Tiny moved(std::move(lar));
+  std::cout << "After move: source size " << lar.size() << ", target size "
+            << moved.size() << std::endl;
+  std::cout << moved;
+
+  // source is empty and usable again
+  lar.push_back(42);
+  lar = std::move(moved);
+  std::cout << "After move assignment size " << lar.size() << std::endl;
+  lar.erase(0);
+  lar.pop_front();
+  lar.pop_front();
+  std::cout << lar;
+
+  lar.clear();
+  lar.push_back(7);
+  std::cout << "After clear " << lar.first() << " nodes "
+            << lar.stats().nodes << std::endl;
+}
+
+struct AssertPolicy : LariatDefaultPolicy {
+  using Checks = LariatAssertChecks;
+};
+
+void test35() // checking policies
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 4;
+  Lariat<int, asize> checked;
+  Lariat<int, asize, LariatUncheckedPolicy> unchecked;
+  for (int i = 0; i < 10; ++i) {
+    checked.push_back(i);
+    unchecked.push_back(i);
+  }
+
+  std::cout << "checked operator[] noexcept "
+            << noexcept(checked[0]) << std::endl;
+  std::cout << "unchecked operator[] noexcept "
+            << noexcept(unchecked[0]) << std::endl;
+  std::cout << "at noexcept " << noexcept(unchecked.at(0)) << std::endl;
+  std::cout << "size noexcept " << noexcept(unchecked.size()) << std::endl;
+
+  int sum = 0;
+  for (int i = 0; i < 10; ++i) {
+    sum += unchecked[i] + unchecked.at(i);
+  }
+  std::cout << "sum " << sum << " first " << unchecked.first() << " last "
+            << unchecked.last() << std::endl;
+
+  Lariat<int, asize, AssertPolicy> asserted(checked);
+  asserted.erase(3);
+  asserted.pop_front();
+  std::cout << "asserted " << asserted[2] << " noexcept "
+            << noexcept(asserted[0]) << std::endl;
+
+  // at checks whatever the policy
+  try {
+    (void)unchecked.at(10);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  try {
+    (void)checked[-1];
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+}
+
+/**
+ * @brief A list and a std::vector that every edit goes to, feature tests
+ * check the list against the vector
+ */
+template<usize Size, typename Policy = LariatDefaultPolicy>
+struct VectorMirror {
+  using List = Lariat<int, Size, Policy>;
+
+  explicit VectorMirror(u32 seed): random{seed} {}
+
+  // a position to insert at, 0..size()
+  auto any_position() -> usize {
+    return random.GetInt(static_cast<u32>(v.size() + 1));
+  }
+
+  // the index of an item, 0..size()-1
+  auto any_index() -> usize {
+    return random.GetInt(static_cast<u32>(v.size()));
+  }
+
+  auto insert(usize at, int value) -> void {
+    lar.insert(at, value);
+    v.insert(v.begin() + static_cast<std::ptrdiff_t>(at), value);
+  }
+
+  auto erase(usize at) -> void {
+    lar.erase(at);
+    v.erase(v.begin() + static_cast<std::ptrdiff_t>(at));
+  }
+
+  auto push_front(int value) -> void {
+    lar.push_front(value);
+    v.insert(v.begin(), value);
+  }
+
+  auto push_back(int value) -> void {
+    lar.push_back(value);
+    v.push_back(value);
+  }
+
+  // compares a list with the vector, a mismatch sticks
+  auto check(const List& list) -> bool {
+    same = same and list.size() == v.size();
+    for (usize i = 0; same and i < v.size(); ++i) {
+      same = list[i] == v[i];
+    }
+    return same;
+  }
+
+  auto check() -> bool { return check(lar); }
+
+  List lar;
+  std::vector<int> v;
+  RandomNumber random;
+  bool same{true};
+};
+
+/**
+ * @brief Runs check on a fresh VectorMirror of each node storage
+ */
+template<usize Size, typename Check>
+void for_each_storage(u32 seed, Check&& check)
+{
+  VectorMirror<Size, LariatDefaultPolicy> window{seed};
+  check(window, "window");
+  VectorMirror<Size, LariatGapPolicy> gap{seed};
+  check(gap, "gap");
+  VectorMirror<Size, LariatTombstonePolicy> tombstone{seed};
+  check(tombstone, "tombstone");
+}
+
+template<typename Mirror>
+void range_edits(Mirror& m, const char* label)
+{
+  // runs go in and come out a node at a time
+  int next_value{0};
+  for (int round = 0; round < 200; ++round) {
+    std::vector<int> values(m.random.GetInt(30));
+    for (int& value : values) {
+      value = next_value++;
+    }
+    const usize at = m.any_position();
+    m.lar.insert(at, LariatSpan<const int>{values.data(), values.size()});
+    m.v.insert(m.v.begin() + static_cast<std::ptrdiff_t>(at), values.begin(),
+               values.end());
+
+    const usize first = m.any_position();
+    const usize last =
+      std::min<usize>(m.v.size(), first + m.random.GetInt(25));
+    m.lar.erase(first, last);
+    m.v.erase(m.v.begin() + static_cast<std::ptrdiff_t>(first),
+              m.v.begin() + static_cast<std::ptrdiff_t>(last));
+    m.check();
+  }
+
+  std::cout << label << " range edits: size " << m.lar.size()
+            << ", same as vector " << m.same << std::endl;
+}
+
+void test36() // batched operations
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 16;
+
+  // a recorded scenario as one batch, against the same ops one at a time
+  LariatScenario sc(20000, 2000, 4, 2, 1, 1, 1, 1, 1, 2, 1, 36);
+  std::vector<LariatBatchOp<int>> batch;
+  for (const auto& op: sc.Get()) {
+    const usize pos = static_cast<usize>(std::get<1>(op));
+    const int val = std::get<2>(op);
+    switch (std::get<0>(op)) {
+      case Insert: batch.push_back({LariatOp::insert, pos, val}); break;
+      case Erase: batch.push_back({LariatOp::erase, pos, val}); break;
+      case Pushback: batch.push_back({LariatOp::push_back, pos, val}); break;
+      case Pushfront: batch.push_back({LariatOp::push_front, pos, val}); break;
+      case Popfront: batch.push_back({LariatOp::pop_front, pos, val}); break;
+      case Popback: batch.push_back({LariatOp::pop_back, pos, val}); break;
+      case Compact: batch.push_back({LariatOp::compact, pos, val}); break;
+      case Index: batch.push_back({LariatOp::read, pos, val}); break;
+      case Find: batch.push_back({LariatOp::find, pos, val}); break;
+    }
+  }
+
+  Lariat<int, asize> lar;
+  lar.enable_index();
+  lar.apply_batch({batch.data(), batch.size()});
+
+  std::vector<int> v;
+  bool results_match = true;
+  for (const LariatBatchOp<int>& op: batch) {
+    const auto at = v.begin() + static_cast<std::ptrdiff_t>(op.position);
+    switch (op.op) {
+      case LariatOp::insert: v.insert(at, op.value); break;
+      case LariatOp::erase: v.erase(at); break;
+      case LariatOp::push_back: v.push_back(op.value); break;
+      case LariatOp::push_front: v.insert(v.begin(), op.value); break;
+      case LariatOp::pop_back: v.pop_back(); break;
+      case LariatOp::pop_front: v.erase(v.begin()); break;
+      case LariatOp::compact: break;
+      case LariatOp::read: results_match &= *at == op.value; break;
+      case LariatOp::find:
+        results_match &= static_cast<usize>(
+                           std::find(v.begin(), v.end(), op.value) - v.begin()
+                         )
+                      == op.position;
+        break;
+    }
+  }
+
+  bool same = lar.size() == v.size();
+  for (unsigned i = 0; same and i < v.size(); ++i) {
+    same = lar[i] == v[i];
+  }
+  std::cout << "Size = " << lar.size() << (same ? " matches" : " differs")
+            << std::endl;
+  std::cout << "Reads and finds " << (results_match ? "match" : "differ")
+            << std::endl;
+
+  // sorted positions sweep the list once
+  Lariat<int, asize, LariatStatsPolicy> one_by_one;
+  Lariat<int, asize, LariatStatsPolicy> batched;
+  for (int i = 0; i < 4000; ++i) {
+    one_by_one.push_back(i);
+    batched.push_back(i);
+  }
+  one_by_one.reset_stats();
+  batched.reset_stats();
+
+  std::vector<LariatBatchOp<int>> sorted;
+  for (usize i = 1; i < 1000; ++i) {
+    sorted.push_back({LariatOp::insert, i * 5, -1});
+    sorted.push_back({LariatOp::read, i * 5 + 1, 0});
+  }
+  for (const LariatBatchOp<int>& op: sorted) {
+    if (op.op == LariatOp::insert) {
+      one_by_one.insert(static_cast<int>(op.position), op.value);
+    } else {
+      (void)one_by_one[static_cast<int>(op.position)];
+    }
+  }
+  batched.apply_batch({sorted.data(), sorted.size()});
+  std::cout << "node hops one by one " << one_by_one.stats().counters.node_hops
+            << std::endl;
+  std::cout << "node hops batched    " << batched.stats().counters.node_hops
+            << std::endl;
+
+  same = batched.size() == one_by_one.size();
+  for (unsigned i = 0; same and i < batched.size(); ++i) {
+    same = batched[i] == one_by_one[i];
+  }
+  std::cout << "Sorted batch " << (same ? "matches" : "differs") << std::endl;
+
+  // inserting and erasing whole runs is the contiguous form of a batch
+  for_each_storage<8>(48, [](auto& m, const char* label) {
+    range_edits(m, label);
+  });
+}
+
+void test37() // gather and scatter
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 32;
+  Lariat<int, asize, LariatStatsPolicy> lar;
+  std::vector<int> v;
+  for (int i = 0; i < 20000; ++i) {
+    lar.insert(i / 2, i);
+    v.insert(v.begin() + i / 2, i);
+  }
+  lar.enable_index();
+
+  // unsorted, with repeats
+  std::vector<int> indices;
+  for (int i = 0; i < 3000; ++i) {
+    indices.push_back((i * 7919) % 20000);
+  }
+  indices.push_back(5);
+  indices.push_back(5);
+
+  lar.reset_stats();
+  std::vector<int> out(indices.size());
+  lar.gather(indices.data(), indices.size(), out.data());
+  std::cout << "gather node hops " << lar.stats().counters.node_hops
+            << std::endl;
+
+  bool same = true;
+  for (unsigned j = 0; j < indices.size(); ++j) {
+    same = same and out[j] == v[static_cast<unsigned>(indices[j])];
+  }
+  std::cout << "gather " << (same ? "matches" : "differs") << std::endl;
+
+  std::vector<int> values;
+  for (unsigned j = 0; j < indices.size(); ++j) {
+    values.push_back(-static_cast<int>(j));
+    v[static_cast<unsigned>(indices[j])] = -static_cast<int>(j);
+  }
+  lar.scatter(indices.data(), values.data(), indices.size());
+  std::cout << "element 5 = " << lar[5] << std::endl;
+
+  same = lar.size() == v.size();
+  for (unsigned i = 0; same and i < v.size(); ++i) {
+    same = lar[i] == v[i];
+  }
+  std::cout << "scatter " << (same ? "matches" : "differs") << std::endl;
+  for (const int value: {-2999, -3000, -1234, 17}) {
+    const auto it = std::find(v.begin(), v.end(), value);
+    std::cout << "find " << value << " " << lar.find(value)
+              << (lar.find(value) == static_cast<u32>(it - v.begin())
+                    ? " matches"
+                    : " differs")
+              << std::endl;
+  }
+
+  // bad index, nothing is written
+  const int bad[] = {1, 20000};
+  const int bad_values[] = {100, 200};
+  try {
+    lar.scatter(bad, bad_values, 2);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  std::cout << "element 1 = " << lar[1] << std::endl;
+}
+
+struct TombstoneStatsPolicy : LariatTombstonePolicy {
+  using Stats = LariatCountingStats;
+};
+
+void test38() // lazily erasing nodes
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 128;
+
+  // thinning out a long list, with the odd insert in between
+  Lariat<int, asize, LariatStatsPolicy> window;
+  Lariat<int, asize, TombstoneStatsPolicy> tomb;
+  std::vector<int> v;
+  for (int i = 0; i < 6000; ++i) {
+    window.push_back(i);
+    tomb.push_back(i);
+    v.push_back(i);
+  }
+  window.reset_stats();
+  tomb.reset_stats();
+  for (int i = 0; i < 4000; ++i) {
+    const int at = (i * 7919) % static_cast<int>(v.size());
+    if (i % 10 == 9) {
+      window.insert(at, -i);
+      tomb.insert(at, -i);
+      v.insert(v.begin() + at, -i);
+    } else {
+      window.erase(at);
+      tomb.erase(at);
+      v.erase(v.begin() + at);
+    }
+  }
+
+  bool same = window.size() == v.size() and tomb.size() == v.size();
+  for (unsigned i = 0; same and i < v.size(); ++i) {
+    same = window[i] == v[i] and tomb[i] == v[i];
+  }
+  std::cout << "Size = " << tomb.size() << (same ? " matches" : " differs")
+            << std::endl;
+  std::cout << "window shifted    " << window.stats().counters.shifted_elements
+            << std::endl;
+  std::cout << "tombstone shifted " << tomb.stats().counters.shifted_elements
+            << std::endl;
+
+  // snapshot and compact see only live items
+  std::stringstream snapshot;
+  tomb.save(snapshot);
+  Lariat<int, 10> loaded;
+  loaded.load(snapshot);
+  tomb.compact();
+  same = loaded.size() == v.size() and tomb.size() == v.size();
+  for (unsigned i = 0; same and i < v.size(); ++i) {
+    same = loaded[i] == v[i] and tomb[i] == v[i];
+  }
+  std::cout << "Snapshot and compact " << (same ? "match" : "differ")
+            << std::endl;
+
+  // random operations against vector
+  LariatScenario sc(5000, 2000, 4, 4, 1, 1, 2, 2, 1, 1, 1, 38);
+  replay_cmp_to_vector<10, LariatTombstonePolicy>(sc);
+  replay_cmp_to_vector<10, LariatTombstonePolicy>(sc, true);
+  replay_cmp_to_vector<70, LariatTombstonePolicy>(sc);
+}
+
+struct ParallelConvertPolicy : LariatDefaultPolicy {
+  static constexpr usize convert_threads = 4;
+  static constexpr usize convert_parallel_min = 1000;
+};
+
+void test39() // converting copies
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+  const int asize = 64;
+
+  // tombstones leave the source nodes with gaps
+  Lariat<int, asize, LariatTombstonePolicy> lar;
+  for (int i = 0; i < 20000; ++i) {
+    lar.push_back(i * 3);
+  }
+  for (int i = 0; i < 4000; ++i) {
+    lar.erase((i * 7919) % static_cast<int>(lar.size()));
+  }
+
+  Lariat<float, 30> pushed;
+  for (unsigned i = 0; i < lar.size(); ++i) {
+    pushed.push_back(static_cast<float>(lar[i]));
+  }
+
+  Lariat<float, 30> copy(lar);
+  Lariat<float, 30, ParallelConvertPolicy> parallel(lar);
+  Lariat<double, 30> assigned;
+  assigned.push_back(-1.0);
+  assigned = lar;
+  Lariat<float, 30, ParallelConvertPolicy> narrowed;
+  narrowed.enable_index();
+  narrowed = assigned;
+
+  bool same = copy.size() == lar.size() and parallel.size() == lar.size()
+          and assigned.size() == lar.size() and narrowed.size() == lar.size();
+  for (unsigned i = 0; same and i < lar.size(); ++i) {
+    const float value = static_cast<float>(lar[i]);
+    same = copy[i] == value and parallel[i] == value
+       and assigned[i] == static_cast<double>(lar[i]) and narrowed[i] == value;
+  }
+  std::cout << "Size = " << copy.size() << (same ? " matches" : " differs")
+            << std::endl;
+  std::stringstream copy_nodes, pushed_nodes;
+  copy_nodes << copy;
+  pushed_nodes << pushed;
+  std::cout << "Nodes "
+            << (copy_nodes.str() == pushed_nodes.str() ? "match" : "differ")
+            << " push_back" << std::endl;
+  std::cout << "find " << narrowed.find(static_cast<float>(lar[500]))
+            << std::endl;
+
+  Lariat<int, asize, LariatTombstonePolicy> empty;
+  copy = empty;
+  std::cout << "Size = " << copy.size() << std::endl;
+}
+
+struct NoPrefetchPolicy : LariatDefaultPolicy {
+  static constexpr usize prefetch_distance = 0;
+};
+
+struct FarPrefetchPolicy : LariatStatsPolicy {
+  static constexpr usize prefetch_distance = 8;
+};
+
+void test40() // prefetch distance
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  // lookups near the tail run the lookahead off the end of the list
+  Lariat<int, 8, FarPrefetchPolicy> lar;
+  for (int i = 0; i < 100; ++i) {
+    lar.push_back(i);
+  }
+  lar.reset_stats();
+  std::cout << "last = " << lar[99] << ", find 97 = " << lar.find(97)
+            << ", find 100 = " << lar.find(100) << std::endl;
+  std::cout << "hops " << lar.stats().counters.node_hops << std::endl;
+
+  // random operations against vector
+  LariatScenario sc(400, 2000, 4, 1, 2, 2, 1, 1, 1, 2, 2, 40);
+  replay_cmp_to_vector<10, NoPrefetchPolicy>(sc);
+  replay_cmp_to_vector<10, FarPrefetchPolicy>(sc);
+}
+
+template<typename Policy>
+void chunk_views(const char* label)
+{
+  Lariat<int, 16, Policy> lar;
+  for (int i = 0; i < 200; ++i) {
+    lar.push_back(i);
+  }
+  for (int i = 0; i < 50; ++i) {
+    lar.insert((i * 37) % static_cast<int>(lar.size()), 1000 + i);
+    lar.erase((i * 53) % static_cast<int>(lar.size()));
+  }
+
+  // bulk consumers see every item once, in order
+  const auto& view = lar;
+  std::vector<int> copied;
+  usize runs = 0;
+  view.for_each_chunk([&](LariatSpan<const int> chunk) {
+    copied.insert(copied.end(), chunk.begin(), chunk.end());
+    runs++;
+  });
+
+  // writes through the mutable chunks land in the list
+  for (LariatSpan<int> chunk: lar.chunks()) {
+    for (int& value: chunk) {
+      value *= 2;
+    }
+  }
+
+  bool same = copied.size() == lar.size();
+  for (unsigned i = 0; same and i < copied.size(); ++i) {
+    same = lar[i] == 2 * copied[i];
+  }
+
+  usize ranged_runs = 0;
+  for (LariatSpan<const int> chunk: view.chunks()) {
+    ranged_runs += chunk.empty() ? 0 : 1;
+  }
+
+  std::cout << label << ": " << copied.size() << " items "
+            << (same ? "match" : "differ") << ", runs "
+            << (runs == ranged_runs ? "agree" : "disagree") << std::endl;
+
+  // the run holding an index continues to the end of its block
+  const LariatSpan<const int> rest = view.chunk_at(37);
+  same = rest.size() > 0;
+  for (unsigned i = 0; same and i < rest.size(); ++i) {
+    same = rest[i] == lar[37 + i];
+  }
+  std::cout << "chunk_at(37) " << (same ? "matches" : "differs") << std::endl;
+
+  // a writable run converts to a read only one, never the other way
+  static_assert(
+    std::is_convertible_v<LariatSpan<int>, LariatSpan<const int>>
+    and not std::is_convertible_v<LariatSpan<const int>, LariatSpan<int>>,
+    "spans only convert towards const"
+  );
+  const LariatSpan<const int> held = lar.chunk_at(37);
+  std::cout << "read only chunk_at(37) "
+            << (held.data() == rest.data() and held.size() == rest.size()
+                  ? "matches" : "differs")
+            << std::endl;
+}
+
+void test41() // chunk views
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  chunk_views<LariatDefaultPolicy>("window");
+  chunk_views<LariatGapPolicy>("gap");
+  chunk_views<LariatTombstonePolicy>("tombstone");
+
+  Lariat<int, 16> lar;
+  lar.push_back(1);
+  try {
+    (void)lar.chunk_at(1);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+}
+
+template<typename Mirror>
+void segmented_algorithms(Mirror& m, const char* label)
+{
+  for (int i = 0; i < 300; ++i) {
+    m.push_front(i % 17);
+  }
+  for (usize i = 0; i < 60; ++i) {
+    m.erase((i * 41) % m.v.size());
+  }
+  auto& lar = m.lar;
+  std::vector<int>& v = m.v;
+  const auto& view = lar;
+
+  std::vector<int> out(v.size());
+  copy(view.begin(), view.end(), out.begin());
+  const bool copied = out == v;
+
+  const bool same = equal(view.begin(), view.end(), v.begin());
+  const bool walked = std::equal(view.begin(), view.end(), v.begin());
+  v[100]++;
+  const bool differs = not equal(view.begin(), view.end(), v.begin());
+  v[100]--;
+
+  const auto found = find(view.begin(), view.end(), 16);
+  const auto expected = std::find(v.begin(), v.end(), 16);
+  const bool found_same =
+    std::distance(view.begin(), found) == expected - v.begin();
+
+  const long sum = accumulate(view.begin(), view.end(), 0l);
+  const long product = accumulate(
+    view.begin(),
+    view.end(),
+    1l,
+    [](long acc, int x) { return (acc * (x + 1)) % 1000003; }
+  );
+
+  std::vector<int> longer = v;
+  longer.push_back(0);
+  const bool less = lexicographical_compare(
+                      view.begin(),
+                      view.end(),
+                      longer.begin(),
+                      longer.end()
+                    )
+                and not lexicographical_compare(
+                      view.begin(),
+                      view.end(),
+                      v.begin(),
+                      v.end()
+                    );
+
+  // writes: vector into the list, fill, list to list
+  std::vector<int> values(v.size());
+  for (unsigned i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<int>(i);
+  }
+  copy(values.begin(), values.end(), lar.begin());
+  bool written = equal(view.begin(), view.end(), values.begin());
+  auto middle = lar.begin();
+  std::advance(middle, 50);
+  auto stop = middle;
+  std::advance(stop, 100);
+  fill(middle, stop, -1);
+  Lariat<int, 7> other;
+  for (unsigned i = 0; i < v.size(); ++i) {
+    other.push_back(0);
+  }
+  copy_n(lar.cbegin(), 120, other.begin());
+  for (unsigned i = 0; written and i < v.size(); ++i) {
+    const int value = i >= 50 and i < 150 ? -1 : static_cast<int>(i);
+    written = lar[i] == value and other[i] == (i < 120 ? value : 0);
+  }
+
+  // stepping back from end
+  auto last = view.end();
+  --last;
+  const bool back = *last == lar[static_cast<int>(lar.size()) - 1]
+                and std::distance(view.begin(), view.end())
+                      == static_cast<std::ptrdiff_t>(v.size());
+
+  std::cout << label << ": copy " << copied << ", equal " << same << walked
+            << differs << ", find " << found_same << ", sum " << sum
+            << ", product " << product << ", less " << less << ", writes "
+            << written << ", back " << back << std::endl;
+}
+
+void test42() // segmented algorithms
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  for_each_storage<16>(42, [](auto& m, const char* label) {
+    segmented_algorithms(m, label);
+  });
+}
+
+struct AutoCompactStatsPolicy : LariatAutoCompactPolicy {
+  using Stats = LariatCountingStats;
+};
+
+template<typename Policy>
+void churn_batches(const char* label)
+{
+  VectorMirror<8, Policy> m{44};
+
+  // batches that grow the list in the middle and at both ends, then erase
+  // most of it again, so that the fill factor drops below the low water mark
+  // partway through a batch
+  for (int round = 0; round < 6; ++round) {
+    std::vector<LariatBatchOp<int>> batch;
+    for (int i = 0; i < 600; ++i) {
+      const usize at = m.any_position();
+      batch.push_back({LariatOp::insert, at, i});
+      m.v.insert(m.v.begin() + static_cast<std::ptrdiff_t>(at), i);
+      if (i % 50 == 0) {
+        batch.push_back({LariatOp::push_front, 0, -i});
+        m.v.insert(m.v.begin(), -i);
+      }
+    }
+    for (int i = 0; i < 560; ++i) {
+      const usize at = m.any_index();
+      batch.push_back({LariatOp::erase, at, 0});
+      m.v.erase(m.v.begin() + static_cast<std::ptrdiff_t>(at));
+      batch.push_back({LariatOp::read, at / 2, 0});
+      if (i % 40 == 0) {
+        batch.push_back({LariatOp::push_back, 0, i});
+        m.v.push_back(i);
+      }
+    }
+    m.lar.apply_batch({batch.data(), batch.size()});
+    m.check();
+  }
+
+  const LariatStatsReport report = m.lar.stats();
+  std::cout << label << " batches: size " << report.size
+            << (m.same ? " matches" : " differs") << ", nodes "
+            << report.nodes << " for " << report.ideal_nodes
+            << ", compactions " << report.counters.compactions << std::endl;
+}
+
+template<typename Policy>
+void churn_occupancy(const char* label)
+{
+  VectorMirror<16, Policy> m{43};
+
+  // grow by inserting in the middle, then churn while shrinking back
+  double worst = 0;
+  for (int round = 0; round < 6; ++round) {
+    for (int i = 0; i < 3000; ++i) {
+      m.insert(m.any_position(), i);
+    }
+    for (int i = 0; i < 2800; ++i) {
+      m.erase(m.any_index());
+
+      const LariatStatsReport report = m.lar.stats();
+      worst = std::max(
+        worst,
+        static_cast<double>(report.nodes)
+          / static_cast<double>(std::max<usize>(report.ideal_nodes, 1))
+      );
+    }
+  }
+  m.check();
+
+  const LariatStatsReport report = m.lar.stats();
+  std::cout << label << ": size " << report.size
+            << (m.same ? " matches" : " differs") << ", nodes "
+            << report.nodes << " for " << report.ideal_nodes
+            << ", worst overhead " << std::setprecision(3) << worst
+            << ", compactions " << report.counters.compactions << std::endl;
+}
+
+void test43() // automatic compaction
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  churn_occupancy<LariatStatsPolicy>("manual");
+  churn_occupancy<AutoCompactStatsPolicy>("automatic");
+  churn_batches<AutoCompactStatsPolicy>("automatic");
+
+  // random operations against vector
+  LariatScenario sc(5000, 2000, 4, 4, 1, 1, 2, 2, 0, 1, 1, 430);
+  replay_cmp_to_vector<10, LariatAutoCompactPolicy>(sc);
+  replay_cmp_to_vector<10, LariatAutoCompactPolicy>(sc, true);
+}
+
+void test44() // 64-bit indices
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  Lariat<int, 8> lar;
+  for (usize i = 0; i < 100; ++i) {
+    lar.insert(i, static_cast<int>(i));
+  }
+
+  // every integer type reaches the usize overloads
+  const usize wide = 10;
+  const long long longer = 20;
+  const unsigned short shorter = 30;
+  lar.erase(wide);
+  lar.insert(longer, -1);
+  lar[shorter] = -2;
+  std::cout << "lar[9] = " << lar[wide - 1] << ", lar[10] = " << lar[wide]
+            << ", lar[20] = " << lar.at(longer) << ", lar[30] = " << lar[30]
+            << std::endl;
+
+  // find keeps its u32 answer, index_of has npos
+  std::cout << "find 50 = " << lar.find(50) << ", index_of 50 = "
+            << lar.index_of(50) << std::endl;
+  std::cout << "find 1000 = " << lar.find(1000) << ", index_of 1000 is npos "
+            << (lar.index_of(1000) == Lariat<int, 8>::npos) << std::endl;
+
+  const usize indices[] = {99, 0, 50};
+  int values[3];
+  lar.gather(indices, 3, values);
+  std::cout << "gathered " << values[0] << " " << values[1] << " " << values[2]
+            << std::endl;
+
+  // negative indices of any signed type are out of range
+  try {
+    lar.erase(-1ll);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  try {
+    (void)lar.at(static_cast<short>(-5));
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  std::cout << "Size = " << lar.size() << std::endl;
+
+  // the page engines take the same index types
+  ArenaLariat<int, 8> pages;
+  for (usize i = 0; i < 100; ++i) {
+    pages.insert(i, static_cast<int>(i));
+  }
+  pages.erase(wide);
+  pages.insert(longer, -1);
+  pages[shorter] = -2;
+  std::cout << "pages[9] = " << pages[wide - 1] << ", pages[10] = "
+            << pages[wide] << ", pages[20] = " << pages[longer]
+            << ", pages[30] = " << pages[30] << std::endl;
+  std::cout << "find 50 = " << pages.find(50) << ", index_of 50 = "
+            << pages.index_of(50) << std::endl;
+  std::cout << "find 1000 = " << pages.find(1000)
+            << ", index_of 1000 is npos "
+            << (pages.index_of(1000) == ArenaLariat<int, 8>::npos)
+            << std::endl;
+  try {
+    pages.erase(-1ll);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  std::cout << "Size = " << pages.size() << std::endl;
+}
+
+#include <cstring>
+
+void test45() // index linked node arena
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  // 32 bit links and a 16 bit count instead of two pointers and a usize
+  std::cout << "page overhead = " << ArenaLariat<int, 5>::page_overhead()
+            << " bytes" << std::endl;
+
+  ArenaLariat<int, 5> lar;
+  Lariat<int, 5> ref;
+  for (int i = 0; i < 60; ++i) {
+    const int pos = (i * 7) % (static_cast<int>(ref.size()) + 1);
+    lar.insert(pos, i);
+    ref.insert(pos, i);
+  }
+  for (int i = 0; i < 20; ++i) {
+    const int pos = (i * 11) % static_cast<int>(ref.size());
+    lar.erase(pos);
+    ref.erase(pos);
+  }
+  lar.push_front(-1);
+  ref.push_front(-1);
+  lar.pop_back();
+  ref.pop_back();
+
+  bool same = lar.size() == ref.size();
+  for (unsigned i = 0; same and i < ref.size(); ++i) {
+    same = lar[static_cast<int>(i)] == ref[i];
+  }
+  std::cout << "Size = " << lar.size() << " nodes = " << lar.node_count()
+            << " same as Lariat " << same << std::endl;
+
+  // growing moved the arena, the links are still good
+  ArenaLariat<int, 5> copy = lar;
+  lar.clear();
+  for (int i = 0; i < 200; ++i) {
+    lar.push_back(i);
+  }
+  std::cout << "copy find 59 = " << copy.find(59) << ", lar last = "
+            << lar.last() << " pages = " << lar.page_capacity() << std::endl;
+
+  // the arena image is a MappedLariat file
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "lariat_test45.map").string();
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    copy.save(file);
+  }
+  {
+    MappedLariat<int, 5> mapped(path);
+    mapped.push_back(1000);
+    std::cout << "mapped size = " << mapped.size() << " first = "
+              << mapped.first() << " last = " << mapped.last() << std::endl;
+  }
+  {
+    std::ifstream file(path, std::ios::binary);
+    lar.load(file);
+  }
+  std::filesystem::remove(path);
+  lar.compact();
+  std::cout << lar;
+
+  // images of another node size are rejected
+  std::stringstream image;
+  copy.save(image);
+  ArenaLariat<int, 6> wrong;
+  try {
+    wrong.load(image);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  std::cout << "Size = " << wrong.size() << std::endl;
+
+  // damaged headers, offsets are those of the region layout
+  const std::string good = image.str();
+  const auto field = [&good](usize offset) {
+    u32 value;
+    std::memcpy(&value, good.data() + offset, sizeof(value));
+    return value;
+  };
+  const auto load_patched = [&good](usize offset, u32 value, usize width) {
+    std::string bad = good;
+    std::memset(&bad[offset], 0, width);
+    std::memcpy(&bad[offset], &value, sizeof(value));
+    std::stringstream damaged(bad);
+    ArenaLariat<int, 5> target;
+    target.push_back(1);
+    try {
+      target.load(damaged);
+    } catch (LariatException& le) {
+      std::cout << "Somethingbad happened: " << le.what() << std::endl;
+    }
+    std::cout << "Size = " << target.size() << std::endl;
+  };
+  const usize size_at = 32;
+  const usize capacity_at = 48;
+  const usize used_at = 56;
+  const usize head_at = 64;
+  const usize free_head_at = 72;
+  load_patched(head_at, field(used_at) + 1, 4);
+  load_patched(free_head_at, field(head_at), 4);
+  load_patched(size_at, field(size_at) + 1, 8);
+  load_patched(capacity_at, 0xFFFFFFFFu, 8);
+}
+
+#include <unordered_set>
+
+void test46() // comparing and hashing lists
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  // same items, different node boundaries and storage
+  Lariat<int, 4> small;
+  Lariat<int, 7, LariatGapPolicy> wide;
+  for (int i = 0; i < 50; ++i) {
+    small.insert(i / 2, i);
+    wide.insert(i / 2, i);
+  }
+  std::cout << "small == wide " << (small == wide) << ", small != wide "
+            << (small != wide) << std::endl;
+  std::cout << "hash equal "
+            << (std::hash<Lariat<int, 4>>{}(small)
+                == std::hash<Lariat<int, 7, LariatGapPolicy>>{}(wide))
+            << std::endl;
+
+  wide[40] = wide[40] + 1;
+  std::cout << "after bump: small < wide " << (small < wide)
+            << ", small > wide " << (small > wide) << ", small <= wide "
+            << (small <= wide) << ", small >= wide " << (small >= wide)
+            << std::endl;
+  wide[40] = wide[40] - 1;
+  wide.pop_back();
+  std::cout << "after pop: wide < small " << (wide < small)
+            << ", small == wide " << (small == wide) << std::endl;
+
+  // lists as keys
+  std::unordered_set<Lariat<int, 8>> seen;
+  for (int i = 0; i < 20; ++i) {
+    Lariat<int, 8> key;
+    for (int j = 0; j < 10 + i % 4; ++j) {
+      key.push_back(j);
+    }
+    seen.insert(key);
+  }
+  std::cout << "distinct keys " << seen.size() << std::endl;
+
+  // items without a plain representation compare item by item
+  Lariat<std::string, 3> words;
+  Lariat<std::string, 5> other;
+  for (const char* word : {"unrolled", "linked", "list", "lariat"}) {
+    words.push_back(word);
+    other.push_back(word);
+  }
+  other.push_back("more");
+  std::cout << "words < other " << (words < other) << ", words == other "
+            << (words == other) << std::endl;
+  other.pop_back();
+  std::cout << "hash equal "
+            << (std::hash<Lariat<std::string, 3>>{}(words)
+                == std::hash<Lariat<std::string, 5>>{}(other))
+            << std::endl;
+}
+
+template<typename Mirror>
+void erase_matching(Mirror& m, const char* name)
+{
+  for (int i = 0; i < 300; ++i) {
+    m.insert((static_cast<usize>(i) * 13) % (m.v.size() + 1), i % 17);
+  }
+
+  const auto odd = [](int value) { return value % 2 != 0; };
+  const usize erased = m.lar.erase_if(odd);
+  m.v.erase(std::remove_if(m.v.begin(), m.v.end(), odd), m.v.end());
+  const usize removed = m.lar.remove(4);
+  m.v.erase(std::remove(m.v.begin(), m.v.end(), 4), m.v.end());
+
+  std::cout << name << ": erased " << erased << ", removed " << removed
+            << ", size " << m.lar.size() << ", same as vector " << m.check()
+            << std::endl;
+}
+
+void test47() // erase_if and remove
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  Lariat<int, 4> lar;
+  for (int i = 0; i < 20; ++i) {
+    lar.insert(i / 2, i);
+  }
+  std::cout << "erased " << lar.erase_if([](int value) {
+    return value % 3 == 0;
+  }) << std::endl;
+  std::cout << lar;
+
+  for_each_storage<6>(47, [](auto& m, const char* name) {
+    erase_matching(m, name);
+  });
+
+  // nodes are filtered on several threads, then packed
+  Lariat<int, 32, LariatStatsPolicy> big;
+  std::vector<int> v;
+  for (int i = 0; i < 20000; ++i) {
+    big.insert(i / 3, i);
+    v.insert(v.begin() + i / 3, i);
+  }
+  const auto unlucky = [](int value) { return value % 7 == 3; };
+  std::cout << "parallel erased " << big.erase_if(unlucky, 4) << std::endl;
+  v.erase(std::remove_if(v.begin(), v.end(), unlucky), v.end());
+  bool same = big.size() == v.size();
+  for (usize i = 0; same and i < v.size(); ++i) {
+    same = big[i] == v[i];
+  }
+  std::cout << "same as vector " << same << ", nodes "
+            << big.stats().nodes << " ideal " << big.stats().ideal_nodes
+            << std::endl;
+  std::cout << "erased everything " << big.erase_if([](int) { return true; })
+            << ", size " << big.size() << std::endl;
+
+  // a throwing predicate keeps what it did not get to
+  Lariat<std::string, 3> words;
+  for (const char* word : {"a", "bb", "ccc", "dd", "e", "fff", "g"}) {
+    words.push_back(word);
+  }
+  try {
+    words.erase_if([](const std::string& word) {
+      if (word == "fff") {
+        throw LariatException{LariatException::E_DATA_ERROR, "fff"};
+      }
+      return word.size() == 1;
+    });
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+  std::cout << words;
+}
+
+void test48() // text buffer with a line index
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  LariatText<8> text{"first line\nsecond\n\nt\xc3\xa9xt with \xc3\xa9 "
+                     "accents\nlast"};
+  std::cout << "bytes " << text.size() << ", code points "
+            << text.codepoint_count() << ", lines " << text.line_count()
+            << std::endl;
+  for (usize line = 0; line < text.line_count(); ++line) {
+    const usize start = text.line_start(line);
+    const usize next = line + 1 < text.line_count()
+                       ? text.line_start(line + 1) - 1
+                       : text.size();
+    std::cout << line << " @" << start << ": ["
+              << text.substr(start, next - start) << "]" << std::endl;
+  }
+
+  // the column counts code points, the accented e is two bytes
+  for (const usize offset : {0, 5, 11, 18, 22, 29, 40, 45}) {
+    const LariatTextPosition at = text.offset_to_line_col(offset);
+    std::cout << "offset " << offset << " -> " << at.line << ":" << at.column
+              << std::endl;
+  }
+
+  text.insert_text(text.line_start(2), "inserted\nlines\n");
+  text.erase_text(0, 6);
+  std::cout << "lines " << text.line_count() << ", line 3 starts at "
+            << text.line_start(3) << std::endl;
+  std::cout << "[" << text.substr(0, text.size()) << "]" << std::endl;
+
+  try {
+    (void)text.line_start(text.line_count());
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+
+  // a long buffer, every line start agrees with a plain scan
+  std::string plain;
+  for (int i = 0; i < 3000; ++i) {
+    plain += std::string(static_cast<usize>(i % 37), 'x') + "\n";
+  }
+  LariatText<64> big{plain};
+  big.erase_text(1000, 500);
+  plain.erase(1000, 500);
+  big.insert_text(20000, "\n\n\n");
+  plain.insert(20000, "\n\n\n");
+
+  const auto newlines = std::count(plain.begin(), plain.end(), '\n');
+  bool same = big.line_count() == static_cast<usize>(newlines) + 1;
+  usize line = 1;
+  for (usize i = 0; same and i < plain.size(); ++i) {
+    if (plain[i] == '\n') {
+      same = big.line_start(line++) == i + 1;
+    }
+  }
+  std::cout << "lines " << big.line_count() << ", same as a scan " << same
+            << std::endl;
+}
+
+template<typename Monoid>
+void range_queries(const char* label)
+{
+  VectorMirror<8, LariatAggregatePolicy<Monoid>> m{49};
+  auto& lar = m.lar;
+
+  const auto fold = [&m](usize first, usize last) {
+    typename Monoid::Value total = Monoid::identity();
+    for (usize i = first; i < last; ++i) {
+      total = Monoid::combine(total, m.v[i]);
+    }
+    return total;
+  };
+
+  // a query over random ranges after each round of edits
+  const auto check = [&]() {
+    m.same = m.check() and lar.summary() == fold(0, m.v.size());
+    for (int i = 0; m.same and i < 200; ++i) {
+      const usize a = m.any_position();
+      const usize b = m.any_position();
+      m.same = lar.range_query(std::min(a, b), std::max(a, b))
+               == fold(std::min(a, b), std::max(a, b));
+    }
+  };
+
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 500; ++i) {
+      const usize at = m.any_position();
+      m.insert(at, static_cast<int>(m.random.GetInt(1000)) - 500);
+    }
+    check();
+    for (int i = 0; i < 200; ++i) {
+      m.erase(m.any_index());
+    }
+    check();
+    lar.compact();
+    check();
+  }
+
+  const auto odd = [](int value) { return value % 2 != 0; };
+  lar.erase_if(odd);
+  m.v.erase(std::remove_if(m.v.begin(), m.v.end(), odd), m.v.end());
+  lar.pop_front();
+  m.v.erase(m.v.begin());
+  lar.pop_back();
+  m.v.pop_back();
+  check();
+
+  std::cout << label << ": size " << lar.size() << ", total "
+            << lar.summary() << ", first half " << lar.range_query(
+              usize{0}, lar.size() / 2) << ", same as a scan " << m.same
+            << std::endl;
+}
+
+void test49() // range aggregates
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  Lariat<int, 4, LariatAggregatePolicy<LariatSum<long>>> sums;
+  for (int i = 1; i <= 20; ++i) {
+    sums.push_back(i);
+  }
+  std::cout << "sum " << sums.summary() << ", [3, 17) "
+            << sums.range_query(3, 17) << ", [5, 5) "
+            << sums.range_query(5, 5) << std::endl;
+  sums.erase(0);
+  sums.insert(10, 100);
+  std::cout << "sum " << sums.summary() << ", [3, 17) "
+            << sums.range_query(3, 17) << std::endl;
+
+  Lariat<double, 4, LariatAggregatePolicy<LariatMin<double>>> lows;
+  for (const double value : {4.5, 2.0, 8.0, -1.5, 3.0, 7.25}) {
+    lows.push_back(value);
+  }
+  std::cout << "min " << lows.summary() << ", [0, 3) "
+            << lows.range_query(0, 3) << ", [4, 6) "
+            << lows.range_query(4, 6) << std::endl;
+  lows.erase(3);
+  std::cout << "min after erasing -1.5 " << lows.summary() << std::endl;
+
+  try {
+    (void)sums.range_query(5, 3);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+
+  range_queries<LariatSum<long>>("sum");
+  range_queries<LariatMin<int>>("min");
+  range_queries<LariatMax<int>>("max");
+}
+
+template<typename Mirror>
+void follow_handles(Mirror& m, const char* label)
+{
+  auto& lar = m.lar;
+  std::vector<int>& v = m.v;
+
+  // values are unique, so the vector tells where each handle should be
+  std::vector<std::pair<LariatHandle, int>> handles;
+  int next_value{0};
+
+  usize stale{0};
+  const auto check = [&](const typename Mirror::List& list) {
+    m.check(list);
+    for (const auto& [handle, value] : handles) {
+      const auto at = std::find(v.begin(), v.end(), value);
+      if (at == v.end()) {
+        m.same = m.same and not list.is_valid(handle)
+                 and list.index_of(handle) == list.npos;
+        continue;
+      }
+      m.same = m.same and list.is_valid(handle) and list.get(handle) == value
+               and list.index_of(handle)
+                     == static_cast<usize>(at - v.begin());
+    }
+  };
+
+  for (int round = 0; round < 6; ++round) {
+    for (int i = 0; i < 400; ++i) {
+      const usize at = m.any_position();
+      const int value = next_value++;
+      if (i % 5 == 0) {
+        m.push_front(value);
+      } else {
+        m.insert(at, value);
+      }
+    }
+    for (int i = 0; i < 20; ++i) {
+      const usize at = m.any_index();
+      handles.emplace_back(lar.handle(at), v[at]);
+    }
+    check(lar);
+
+    for (int i = 0; i < 250; ++i) {
+      m.erase(m.any_index());
+    }
+    check(lar);
+
+    lar.compact();
+    check(lar);
+
+    // overwriting in place keeps the handles, they see the new values
+    std::vector<usize> spots;
+    std::vector<int> fresh;
+    for (usize at = static_cast<usize>(round); at < v.size(); at += 7) {
+      spots.push_back(at);
+      fresh.push_back(next_value++);
+      for (auto& [handle, value] : handles) {
+        if (value == v[at]) {
+          value = fresh.back();
+        }
+      }
+      v[at] = fresh.back();
+    }
+    lar.scatter(spots.data(), fresh.data(), spots.size());
+    check(lar);
+
+    const auto unlucky = [round](int value) { return value % 11 == round; };
+    lar.erase_if(unlucky, 4);
+    v.erase(std::remove_if(v.begin(), v.end(), unlucky), v.end());
+    check(lar);
+  }
+
+  for (const auto& [handle, value] : handles) {
+    stale += not lar.is_valid(handle);
+  }
+
+  // a released slot is reused with a new generation
+  const LariatHandle first = handles.back().first;
+  handles.pop_back();
+  lar.release(first);
+  const LariatHandle again = lar.handle(usize{0});
+  m.same = m.same and not lar.is_valid(first) and lar.index_of(again) == 0;
+
+  // handles move along with the list
+  typename Mirror::List moved{std::move(lar)};
+  check(moved);
+  m.same = m.same and moved.index_of(again) == 0;
+  moved.clear();
+
+  std::cout << label << ": size " << v.size() << ", " << stale
+            << " of " << handles.size() << " handles stale, same as a scan "
+            << m.same << ", cleared " << moved.is_valid(again) << std::endl;
+}
+
+void test50() // stable handles
+{
+  std::cout << "-------- " << __func__ << " --------\n";
+
+  Lariat<int, 4> lar;
+  for (int i = 0; i < 10; ++i) {
+    lar.push_back(i * 10);
+  }
+  const LariatHandle fifty = lar.handle(5);
+  const LariatHandle ninety = lar.handle(9);
+  std::cout << "fifty at " << lar.index_of(fifty) << ", ninety at "
+            << lar.index_of(ninety) << std::endl;
+
+  lar.insert(0, -1);
+  lar.insert(3, -3);
+  lar.push_front(-2);
+  lar.erase(7);
+  std::cout << "fifty at " << lar.index_of(fifty) << " holds "
+            << lar.get(fifty) << ", ninety at " << lar.index_of(ninety)
+            << std::endl;
+
+  lar.get(fifty) = 55;
+  lar.erase(lar.index_of(ninety));
+  std::cout << "ninety valid " << lar.is_valid(ninety) << ", at "
+            << (lar.index_of(ninety) == lar.npos ? "npos" : "?")
+            << ", nothing valid " << lar.is_valid(LariatHandle{})
+            << std::endl;
+  std::cout << lar;
+
+  try {
+    (void)lar.get(ninety);
+  } catch (LariatException& le) {
+    std::cout << "Somethingbad happened: " << le.what() << std::endl;
+  }
+
+  for_each_storage<8>(50, [](auto& m, const char* label) {
+    follow_handles(m, label);
+  });
+  VectorMirror<8, LariatInlinePolicy> inline_mirror{50};
+  follow_handles(inline_mirror, "inline");
+}
+
 void (*pTests[])(void
-) = {test0,  test1,  test2,  test3,  test4,  test5,  test6,  test7,  test8,
-     test9,  test10, test11, test12, test13, test14, test15, test16, test17,
-     test18, test19, test20, test21, test22, test23, test24, test25, test26};
+) = {test0,  test1,  test2,  test3,  test4,  test5,  test6,  test7,
+     test8,  test9,  test10, test11, test12, test13, test14, test15,
+     test16, test17, test18, test19, test20, test21, test22, test23,
+     test24, test25, test26, test27, test28, test29, test30, test31,
+     test32, test33, test34, test35, test36, test37, test38,
+     test39, test40, test41, test42, test43,
+     test44, test45, test46, test47, test48, test49,
+     test50};
 
 void test_all() {
   for (size_t i = 0; i < sizeof(pTests) / sizeof(pTests[0]); ++i) {
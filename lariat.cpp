@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <cassert>
 #include <exception>
 #include <iostream>
 #include <iomanip>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
 
 #define LARIAT_CPP
 
@@ -10,14 +13,58 @@
   #include "lariat.h"
 #endif
 
-template<typename T, usize Size>
-std::ostream& operator<<(std::ostream& os, const Lariat<T, Size>& list) {
-  typename Lariat<T, Size>::LNode* current = list.head_;
+template<typename T, usize Size, typename Policy>
+struct Lariat<T, Size, Policy>::ValueIndex {
+  struct Entry {
+    // node holding the first occurrence of the value
+    LNode* node;
+
+    // number of occurrences in the whole list
+    usize count;
+  };
+
+  std::unordered_map<T, Entry> entries{};
+
+  // cached node offsets are only trusted when below this global index, any
+  // mutation lowers it to the mutated position
+  usize clean_below{0};
+};
+
+template<typename T, usize Size, typename Policy>
+struct Lariat<T, Size, Policy>::HandleTable {
+  struct Slot {
+    // node holding the element, nullptr while the slot is free
+    LNode* node;
+
+    // index of the element within node
+    usize index;
+
+    u32 generation;
+
+    // next free slot while this one is free, 0 ends the chain
+    u32 next_free;
+  };
+
+  // slot 0 is never handed out, so a default LariatHandle refers to nothing
+  std::vector<Slot> slots{Slot{nullptr, 0, 0, 0}};
+
+  u32 free_head{0};
+
+  // back-pointers, the slots of the elements of every node that has any
+  std::unordered_map<const LNode*, std::vector<u32>> nodes{};
+};
+
+template<typename T, usize Size, typename Policy>
+std::ostream& operator<<(
+  std::ostream& os,
+  const Lariat<T, Size, Policy>& list
+) {
+  typename Lariat<T, Size, Policy>::LNode* current = list.head_;
   usize index = 0;
   while (current) {
     os << "Node starting (count " << current->count << ")\n";
     for (usize local_index = 0; local_index < current->count; ++local_index) {
-      os << index << " -> " << current->values[local_index] << std::endl;
+      os << index << " -> " << (*current)[local_index] << std::endl;
       ++index;
     }
     os << "-----------\n";
@@ -26,38 +73,40 @@ std::ostream& operator<<(std::ostream& os, const Lariat<T, Size>& list) {
   return os;
 }
 
-template<typename T, usize Size>
-Lariat<T, Size>::Lariat() {}
+template<typename T, usize Size, typename Policy>
+Lariat<T, Size, Policy>::Lariat() noexcept {}
 
-template<typename T, usize Size>
-Lariat<T, Size>::Lariat(const Lariat& rhs) {
+template<typename T, usize Size, typename Policy>
+Lariat<T, Size, Policy>::Lariat(const Lariat& rhs) {
   for (const LNode* node = rhs.head_; node; node = node->next) {
     for (usize i = 0; i < node->count; i++) {
-      push_back(node->values[i]);
+      push_back((*node)[i]);
     }
   }
 }
 
-template<typename T, usize Size>
-template<typename S, usize OtherSize>
-Lariat<T, Size>::Lariat(const Lariat<S, OtherSize>& rhs) {
-  using Node = typename Lariat<S, OtherSize>::LNode;
+template<typename T, usize Size, typename Policy>
+template<typename S, usize OtherSize, typename OtherPolicy>
+Lariat<T, Size, Policy>::Lariat(const Lariat<S, OtherSize, OtherPolicy>& rhs) {
+  convert_from(rhs);
+}
 
-  for (const Node* node = rhs.head_; node; node = node->next) {
-    for (usize i = 0; i < node->count; i++) {
-      push_back(static_cast<T>(node->values[i]));
-    }
-  }
+template<typename T, usize Size, typename Policy>
+Lariat<T, Size, Policy>::Lariat(Lariat&& rhs) noexcept(
+  not Policy::inline_node
+) {
+  take(rhs);
 }
 
-template<typename T, usize Size>
-Lariat<T, Size>::~Lariat() {
-  // TODO:
+template<typename T, usize Size, typename Policy>
+Lariat<T, Size, Policy>::~Lariat() {
   clear();
+  disable_index();
+  delete handles_;
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::operator=(const Lariat& rhs) -> Lariat& {
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::operator=(const Lariat& rhs) -> Lariat& {
   // TODO:
   if (&rhs == this) {
     return *this;
@@ -66,95 +115,87 @@ auto Lariat<T, Size>::operator=(const Lariat& rhs) -> Lariat& {
   clear();
   for (const LNode* node = rhs.head_; node; node = node->next) {
     for (usize i = 0; i < node->count; i++) {
-      push_back(node->values[i]);
+      push_back((*node)[i]);
     }
   }
 
   return *this;
 }
 
-template<typename T, usize Size>
-template<typename S, usize OtherSize>
-auto Lariat<T, Size>::operator=(const Lariat<S, OtherSize>& rhs) -> Lariat& {
-  static_assert(Size != OtherSize, "Wrong Operator (SFINAE)");
-
-  using Node = typename Lariat<S, OtherSize>::LNode;
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::operator=(Lariat&& rhs) -> Lariat& {
+  if (&rhs == this) {
+    return *this;
+  }
 
   clear();
-
-  for (const Node* node = rhs.head_; node; node = node->next) {
-    for (usize i = 0; i < node->count; i++) {
-      push_back(static_cast<T>(node->values[i]));
-    }
-  }
+  disable_index();
+  delete handles_;
+  take(rhs);
 
   return *this;
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::insert(const int index_signed, const T& value) -> void {
-  // TODO:
-  const usize index = static_cast<usize>(index_signed);
+template<typename T, usize Size, typename Policy>
+template<typename S, usize OtherSize, typename OtherPolicy>
+auto Lariat<T, Size, Policy>::operator=(
+  const Lariat<S, OtherSize, OtherPolicy>& rhs
+) -> Lariat& {
+  static_assert(
+    not std::is_same_v<Lariat, Lariat<S, OtherSize, OtherPolicy>>,
+    "Wrong Operator (SFINAE)"
+  );
+
+  clear();
+  convert_from(rhs);
+
+  return *this;
+}
 
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::insert(const usize index, const T& value)
+  -> void {
   if (index == size()) {
     push_back(value);
     return;
   }
 
-  if (index > size()) {
-    throw LariatException{LariatException::E_BAD_INDEX};
-  }
+  Policy::Checks::check(index <= size());
 
   if (index == 0) {
     push_front(value);
     return;
   }
 
-  const FindResult result = find_element(index);
-
-  LNode* node = &result.node;
-  usize local_index = result.index;
-
-  // book keeping
-
-  if (not node->is_full()) {
-    node->values[node->count++] = value;
-    size_++;
-    shift_up(*node, local_index);
-    return;
-  }
-
-  T overflow = node->values[node->count - 1];
-  shift_up(*node, local_index);
-  node->values[local_index] = value;
+  const auto [node, local_index] = find_element(index);
+  insert_at(node, local_index, index, value);
+  check_occupancy();
+}
 
-  node->count++;
-  split(*node);
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::push_back(const T& value) -> void {
+  append(value);
+  check_occupancy();
+}
 
-  node->next->values[node->next->count - 1] = overflow;
-  size_++;
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::push_front(const T& value) -> void {
+  prepend(value);
+  check_occupancy();
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::push_back(const T& value) -> void {
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::append(const T& value) -> void {
   if (not tail_) {
     head_ = make_node();
     tail_ = head_;
-  } else if (tail_->is_full()) {
-    size_++;
-    tail_->count++;
-    split(*tail_);
-    tail_->values[tail_->count - 1] = value;
-    return;
   }
 
-  tail_->values[tail_->count] = value;
-  tail_->count++;
-  size_++;
+  insert_at(*tail_, tail_->count, size(), value);
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::push_front(const T& value) -> void {
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::prepend(const T& value) -> void {
   if (not head_) {
     head_ = make_node();
     tail_ = head_;
@@ -162,139 +203,320 @@ auto Lariat<T, Size>::push_front(const T& value) -> void {
     split(*head_);
   }
 
-  head_->values[head_->count] = value;
-  head_->count++;
-  shift_up(*head_, 0);
-  size_++;
+  insert_at(*head_, 0, 0, value);
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::erase(const int index_signed) -> void {
-  const usize index = static_cast<usize>(index_signed);
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::erase(const usize index) -> void {
+  Policy::Checks::check(index < size());
 
-  if (index >= size()) {
-    throw LariatException{LariatException::E_BAD_INDEX};
+  const auto [node, local_index] = find_element(index);
+  remove_at(node, local_index, index);
+  check_occupancy();
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::pop_back() -> void {
+  Policy::Checks::check(size() != 0);
+
+  remove_at(*tail_, tail_->count - 1, size() - 1);
+  check_occupancy();
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::pop_front() -> void {
+  Policy::Checks::check(size() != 0);
+
+  remove_at(*head_, 0, 0);
+  check_occupancy();
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::insert(
+  const usize index,
+  const LariatSpan<const T> values
+) -> void {
+  Policy::Checks::check(index <= size_);
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (index_) {
+      for (usize i = 0; i < values.size(); i++) {
+        insert(index + i, values[i]);
+      }
+      return;
+    }
   }
 
-  if (index + 1 == size()) {
-    pop_back();
+  if (values.empty()) {
     return;
   }
 
-  if (index == 0) {
-    pop_front();
+  if (not head_) {
+    head_ = make_node();
+    tail_ = head_;
+  }
+
+  const auto [node, local] = index == size_ ? FindResult{*tail_, tail_->count}
+                                            : find_element(index);
+  const T* from = values.data();
+  usize left = values.size();
+
+  if (left <= Size - node.count) {
+    fill_node(node, local, from, left);
+    check_occupancy();
     return;
   }
 
-  const auto [node, local_index] = find_element(index);
+  // the items behind index move out of the way, the values then fill node
+  // and whole new nodes up to them
+  if (local < node.count) {
+    split_at(node, local);
+  }
 
-  shift_down(node, local_index);
-  node.count--;
-  size_--;
+  usize n = std::min(left, Size - node.count);
+  fill_node(node, local, from, n);
+  from += n;
+  left -= n;
+
+  LNode* at = &node;
+  while (left > 0) {
+    LNode* const next = at->next;
+    if (next and left <= Size - next->count) {
+      fill_node(*next, 0, from, left);
+      break;
+    }
+
+    LNode* const fresh = make_node(at, next);
+    if (next) {
+      next->prev = fresh;
+    } else {
+      tail_ = fresh;
+    }
+    at->next = fresh;
+
+    n = std::min(left, usize{Size});
+    fill_node(*fresh, 0, from, n);
+    from += n;
+    left -= n;
+    at = fresh;
+  }
+
+  check_occupancy();
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::pop_back() -> void {
-  if (size() == 0) {
-    throw LariatException{LariatException::E_BAD_INDEX};
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::erase(const usize first, const usize last)
+  -> void {
+  Policy::Checks::check(first <= last and last <= size_);
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (index_) {
+      for (usize i = first; i < last; i++) {
+        erase(first);
+      }
+      return;
+    }
   }
 
-  LNode* last = tail_;
-  while (last->count == 0) {
-    last = last->prev;
+  if (first == last) {
+    return;
   }
-  last->count--;
-  size_--;
+
+  auto [node, local] = find_element(first);
+  LNode* at = &node;
+  usize left = last - first;
+  while (left > 0) {
+    LNode* const next = at->next;
+    const usize n = std::min(left, at->count - local);
+    if (n == at->count) {
+      handles_erase(*at, 0, n);
+      size_ -= n;
+      at->set_front(0);
+      unlink(*at);
+    } else {
+      drain_node(*at, local, n);
+    }
+
+    left -= n;
+    local = 0;
+    at = next;
+  }
+
+  check_occupancy();
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::pop_front() -> void {
-  shift_down(*head_, 0);
-  head_->count--;
-  size_--;
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::operator[](const usize i) noexcept(
+  Policy::Checks::nothrow
+) -> T& {
+  Policy::Checks::check(i < size());
+
+  const auto [node, index] = find_element(i);
+  return node[index];
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::operator[](const int index_signed) -> T& {
-  const auto [node, index] = find_element(static_cast<usize>(index_signed));
-  return node.values[index];
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::operator[](const usize i) const
+  noexcept(Policy::Checks::nothrow) -> const T& {
+  Policy::Checks::check(i < size());
+
+  const auto [node, index] = find_element(i);
+  return node[index];
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::operator[](const int index_signed) const -> const T& {
-  const auto [node, index] = find_element(static_cast<usize>(index_signed));
-  return node.values[index];
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::at(const usize i) -> T& {
+  LariatThrowChecks::check(i < size());
+
+  const auto [node, index] = find_element(i);
+  return node[index];
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::first() -> T& {
-  if (not size()) {
-    throw LariatException{LariatException::E_BAD_INDEX};
-  }
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::at(const usize i) const -> const T& {
+  LariatThrowChecks::check(i < size());
 
-  return (*this)[0];
+  const auto [node, index] = find_element(i);
+  return node[index];
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::first() const -> const T& {
-  if (not size()) {
-    throw LariatException{LariatException::E_BAD_INDEX};
-  }
+template<typename T, usize Size, typename Policy>
+template<typename Index, typename>
+auto Lariat<T, Size, Policy>::insert(const Index index, const T& value)
+  -> void {
+  insert(static_cast<usize>(index), value);
+}
 
-  return (*this)[0];
+template<typename T, usize Size, typename Policy>
+template<typename Index, typename>
+auto Lariat<T, Size, Policy>::erase(const Index index) -> void {
+  erase(static_cast<usize>(index));
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::last() -> T& {
-  if (not size()) {
-    throw LariatException{LariatException::E_BAD_INDEX};
-  }
+template<typename T, usize Size, typename Policy>
+template<typename Index, typename>
+auto Lariat<T, Size, Policy>::operator[](const Index index) noexcept(
+  Policy::Checks::nothrow
+) -> T& {
+  return (*this)[static_cast<usize>(index)];
+}
 
-  LNode* node = tail_;
-  while (node->count == 0) {
-    node = node->prev;
-  }
+template<typename T, usize Size, typename Policy>
+template<typename Index, typename>
+auto Lariat<T, Size, Policy>::operator[](const Index index) const
+  noexcept(Policy::Checks::nothrow) -> const T& {
+  return (*this)[static_cast<usize>(index)];
+}
 
-  return node->values[node->count - 1];
+template<typename T, usize Size, typename Policy>
+template<typename Index, typename>
+auto Lariat<T, Size, Policy>::at(const Index index) -> T& {
+  return at(static_cast<usize>(index));
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::last() const -> const T& {
-  if (not size()) {
-    throw LariatException{LariatException::E_BAD_INDEX};
-  }
+template<typename T, usize Size, typename Policy>
+template<typename Index, typename>
+auto Lariat<T, Size, Policy>::at(const Index index) const -> const T& {
+  return at(static_cast<usize>(index));
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::first() noexcept(Policy::Checks::nothrow)
+  -> T& {
+  Policy::Checks::check(size() != 0);
 
-  return (*this)[size_ - 1];
+  return (*head_)[0];
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::find(const T& value) const -> u32 {
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::first() const noexcept(Policy::Checks::nothrow)
+  -> const T& {
+  Policy::Checks::check(size() != 0);
+
+  return (*head_)[0];
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::last() noexcept(Policy::Checks::nothrow) -> T& {
+  Policy::Checks::check(size() != 0);
+
+  return (*tail_)[tail_->count - 1];
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::last() const noexcept(Policy::Checks::nothrow)
+  -> const T& {
+  Policy::Checks::check(size() != 0);
+
+  return (*tail_)[tail_->count - 1];
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::find(const T& value) const -> u32 {
+  const usize i = index_of(value);
+  return static_cast<u32>(i == npos ? size() : i);
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::index_of(const T& value) const -> usize {
+  if constexpr (LariatIsHashable<T>::value) {
+    if (index_) {
+      const auto entry = index_->entries.find(value);
+      if (entry == index_->entries.end()) {
+        return npos;
+      }
+
+      const LNode& node = *entry->second.node;
+      for (usize j = 0; j < node.count; j++) {
+        if (node[j] == value) {
+          return index_offset(node) + j;
+        }
+      }
+    }
+  }
+
   usize i = 0;
 
+  Lookahead ahead{head_, size_ / Size};
   for (LNode* node = head_; node; node = node->next) {
+    ahead.step();
+    if constexpr (Policy::prefetch_distance > 0) {
+      // the next header is loaded by now, start on its first items
+      if (node->next) {
+        const char* items =
+          reinterpret_cast<const char*>(&(*node->next)[0]);
+        lariat_prefetch(items);
+        lariat_prefetch(items + 64);
+      }
+    }
+
     for (usize j = 0; j < node->count; j++) {
-      if (node->values[j] == value) {
-        return static_cast<u32>(i + j);
+      if ((*node)[j] == value) {
+        return i + j;
       }
     }
     i += node->count;
   }
 
-  return static_cast<u32>(size());
+  return npos;
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::size() const -> usize {
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::size() const noexcept -> usize {
   return size_;
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::compact() -> void {
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::compact() -> void {
   if (size() == 0) {
     clear();
     return;
   }
 
+  for (LNode* node = head_; node; node = node->next) {
+    stats_.on_shift(node->purge());
+  }
+
   // if only one node then this is compact
   if (nodecount_ == 1) {
     return;
@@ -304,47 +526,30 @@ auto Lariat<T, Size>::compact() -> void {
     return;
   }
 
-  while (head_->count == 0) {
-    LNode* next = head_->next;
-
-    delete next;
-    nodecount_--;
+  stats_.on_compact();
 
-    head_ = next;
-  }
-  head_->prev = nullptr;
+  // compaction keeps the order, every handle keeps its global index
+  const std::vector<PlacedHandle> placed = collect_handles();
 
+  // the write cursor never overtakes the read cursor, so elements can be moved
+  // in place front to back, each node is slid to the front of its array before
+  // it is written so that it can fill up to Size
   LNode* dest{head_};
-  LNode* src{dest ? dest->next : nullptr};
-
-  constexpr usize write_end{Size};
   usize write_idx{dest->count};
-  usize read_idx{0}, read_end{src->count};
-
-  usize global_write_idx{head_->count};
-
-  while (dest and src and global_write_idx < size()) {
-    if (write_idx == write_end) {
-      write_idx = 0;
-      dest = dest->next;
-      continue;
-    }
-
-    if (read_idx == read_end) {
-      src = src->next;
-      if (not src) {
-        break;
+  dest->slide(0);
+
+  for (LNode* src = head_->next; src; src = src->next) {
+    for (usize read_idx = 0; read_idx < src->count; read_idx++) {
+      if (write_idx == Size) {
+        dest->set_front(Size);
+        dest = dest->next;
+        dest->slide(0);
+        write_idx = 0;
       }
-      read_idx = 0;
-      read_end = src->count;
-      continue;
+      dest->slots[write_idx++] = std::move((*src)[read_idx]);
     }
-
-    dest->values[write_idx++] = src->values[read_idx++];
-    global_write_idx++;
-    dest->count++;
-    src->count--;
   }
+  dest->set_front(write_idx);
 
   tail_ = dest;
   LNode* delete_pos = tail_->next;
@@ -352,108 +557,2744 @@ auto Lariat<T, Size>::compact() -> void {
 
   while (delete_pos) {
     LNode* tmp = delete_pos->next;
-    nodecount_--;
-    delete delete_pos;
+    destroy_node(delete_pos);
     delete_pos = tmp;
   }
+
+  place_handles(placed);
+  rebuild_index();
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::clear() -> void {
-  while (head_) {
-    LNode* next = head_->next;
-    delete head_;
-    head_ = next;
+template<typename T, usize Size, typename Policy>
+template<typename Pred>
+auto Lariat<T, Size, Policy>::erase_if(Pred pred) -> usize {
+  if (size_ == 0) {
+    return 0;
   }
-  tail_ = nullptr;
-  size_ = 0;
-  nodecount_ = 0;
-  asize_ = 0;
-}
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::LNode::is_full() const -> bool {
-  return count == Size;
+  return pack_if(pred);
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::make_node(LNode* prev, LNode* next) const -> LNode* {
-  try {
-    LNode* node = new LNode();
-    node->prev = prev;
-    node->next = next;
-    nodecount_++;
-    return node;
-  } catch (const std::bad_alloc&) {
-    throw LariatException{LariatException::E_NO_MEMORY};
+template<typename T, usize Size, typename Policy>
+template<typename Pred>
+auto Lariat<T, Size, Policy>::erase_if(Pred pred, const usize threads)
+  -> usize {
+  // handles are carried along by the packing cursors, which only see the
+  // elements that are dropped when they test them
+  const usize shares = std::min(threads, nodecount_);
+  if (shares <= 1 or handles_) {
+    return erase_if(pred);
   }
-}
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::shift_up(LNode& node, const usize index) -> void {
-  if (index >= Size) {
-    throw LariatException{LariatException::E_BAD_INDEX};
+  std::vector<LNode*> nodes;
+  nodes.reserve(nodecount_);
+  for (LNode* node = head_; node; node = node->next) {
+    nodes.push_back(node);
+  }
+
+  struct Share {
+    usize dropped{0};
+    usize moved{0};
+    std::exception_ptr failure;
+  };
+
+  std::vector<Share> results(shares);
+  const auto filter_share = [&](usize share) {
+    const usize first = nodes.size() * share / shares;
+    const usize last = nodes.size() * (share + 1) / shares;
+    Share& result = results[share];
+    for (usize i = first; i < last; i++) {
+      result.dropped +=
+        filter_node(*nodes[i], pred, result.moved, result.failure);
+    }
+  };
+
+  // shares that cannot get a thread of their own run on this one
+  std::vector<std::thread> workers;
+  workers.reserve(shares - 1);
+  usize share{1};
+  for (; share < shares; share++) {
+    try {
+      workers.emplace_back(filter_share, share);
+    } catch (...) {
+      break;
+    }
+  }
+  for (; share < shares; share++) {
+    filter_share(share);
+  }
+
+  filter_share(0);
+  for (std::thread& worker: workers) {
+    worker.join();
+  }
+
+  usize dropped{0};
+  usize moved{0};
+  std::exception_ptr failure;
+  for (const Share& result: results) {
+    dropped += result.dropped;
+    moved += result.moved;
+    if (not failure) {
+      failure = result.failure;
+    }
   }
+  size_ -= dropped;
+  stats_.on_shift(moved);
 
-  for (usize i = index + 1; i < node.count; i++) {
-    swap(node.values[index], node.values[i]);
+  // the nodes are filtered, what is left is packing them
+  auto keep = [](const T&) { return false; };
+  pack_if(keep);
+
+  if (failure) {
+    std::rethrow_exception(failure);
   }
+
+  return dropped;
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::shift_down(LNode& node, usize index) -> void {
-  if (index >= Size) {
-    throw LariatException{LariatException::E_BAD_INDEX};
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::remove(const T& value) -> usize {
+  return erase_if([&value](const T& item) { return item == value; });
+}
+
+template<typename T, usize Size, typename Policy>
+template<typename Pred>
+auto Lariat<T, Size, Policy>::pack_if(Pred& pred) -> usize {
+  std::exception_ptr failure;
+  usize dropped{0};
+  usize moved{0};
+
+  std::vector<PlacedHandle> placed = collect_handles();
+  usize next_handle{0};
+  usize read{0};
+
+  // the same two cursors as compact, except that both start at the head and
+  // the write cursor falls behind as items are dropped
+  LNode* dest{head_};
+  usize write_idx{0};
+  moved += dest->slide(0);
+
+  for (LNode* src = head_; src; src = src->next) {
+    for (usize read_idx = 0; read_idx < src->count; read_idx++, read++) {
+      bool drop{false};
+      if (not failure) {
+        try {
+          drop = pred(std::as_const((*src)[read_idx]));
+        } catch (...) {
+          failure = std::current_exception();
+        }
+      }
+
+      // handles follow their element to the write cursor or go stale
+      while (next_handle < placed.size()
+             and placed[next_handle].global == read) {
+        PlacedHandle& handle = placed[next_handle++];
+        if (drop) {
+          retire_handle(handle.slot);
+        } else {
+          handle.global = read - dropped;
+        }
+      }
+
+      if (drop) {
+        dropped++;
+        continue;
+      }
+
+      if (write_idx == Size) {
+        dest->set_front(Size);
+        dest = dest->next;
+        moved += dest->slide(0);
+        write_idx = 0;
+      }
+
+      if (dest != src or write_idx != read_idx) {
+        dest->slots[write_idx] = std::move((*src)[read_idx]);
+        moved++;
+      }
+      write_idx++;
+    }
+  }
+
+  size_ -= dropped;
+  stats_.on_shift(moved);
+
+  if (size_ == 0) {
+    clear();
+  } else {
+    dest->set_front(write_idx);
+
+    tail_ = dest;
+    LNode* delete_pos = tail_->next;
+    tail_->next = nullptr;
+
+    while (delete_pos) {
+      LNode* tmp = delete_pos->next;
+      destroy_node(delete_pos);
+      delete_pos = tmp;
+    }
+
+    place_handles(placed);
+    rebuild_index();
+  }
+
+  if (failure) {
+    std::rethrow_exception(failure);
   }
 
-  for (usize i = index; i < Size - 2; i++) {
-    node.values[i] = node.values[i + 1];
+  return dropped;
+}
+
+template<typename T, usize Size, typename Policy>
+template<typename Pred>
+auto Lariat<T, Size, Policy>::filter_node(
+  LNode& node,
+  Pred& pred,
+  usize& moved,
+  std::exception_ptr& failure
+) -> usize {
+  moved += node.slide(0);
+
+  usize write_idx{0};
+  for (usize read_idx = 0; read_idx < node.count; read_idx++) {
+    if (not failure) {
+      try {
+        if (pred(std::as_const(node.slots[read_idx]))) {
+          continue;
+        }
+      } catch (...) {
+        failure = std::current_exception();
+      }
+    }
+
+    if (write_idx != read_idx) {
+      node.slots[write_idx] = std::move(node.slots[read_idx]);
+      moved++;
+    }
+    write_idx++;
   }
+
+  const usize dropped = node.count - write_idx;
+  node.set_front(write_idx);
+  return dropped;
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::split(LNode& node) -> void {
-  LNode* const next = make_node(&node, node.next);
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::apply_batch(LariatSpan<LariatBatchOp<T>> ops)
+  -> void {
+  Cursor cursor{head_, 0};
+  bool compact_pending{false};
 
-  node.next = next;
+  // a compaction would free the nodes the cursor walks, so the occupancy is
+  // only checked once the whole batch is in
 
-  const usize sep_index = (node.count + 1) / 2;
+  try {
+    for (LariatBatchOp<T>& op: ops) {
+      // an empty list may have been refilled by the previous operation
+      if (not cursor.node) {
+        cursor = {head_, 0};
+      }
 
-  for (usize i = sep_index; i < node.count; i++) {
-    next->values[i - sep_index] = node.values[i];
+      switch (op.op) {
+        case LariatOp::insert: {
+          Policy::Checks::check(op.position <= size_);
+
+          // the ends keep the split behaviour of push_front/push_back
+          if (op.position == 0) {
+            prepend(op.value);
+            cursor = {head_, 0};
+            break;
+          }
+
+          if (op.position == size_) {
+            append(op.value);
+            break;
+          }
+
+          const auto [node, index] = seek(cursor, op.position);
+          const FindResult placed =
+            insert_at(node, index, op.position, op.value);
+          cursor = {&placed.node, op.position - placed.index};
+          break;
+        }
+
+        case LariatOp::push_back: append(op.value); break;
+
+        case LariatOp::push_front:
+          prepend(op.value);
+          cursor = {head_, 0};
+          break;
+
+        case LariatOp::erase:
+        case LariatOp::pop_back:
+        case LariatOp::pop_front: {
+          Policy::Checks::check(size_ != 0);
+
+          const usize global = op.op == LariatOp::erase    ? op.position
+                             : op.op == LariatOp::pop_back ? size_ - 1
+                                                           : 0;
+          Policy::Checks::check(global < size_);
+
+          // emptied nodes stay linked so that the cursor remains valid
+          const auto [node, index] = seek(cursor, global);
+          remove_at(node, index, global, false);
+          break;
+        }
+
+        case LariatOp::read: {
+          Policy::Checks::check(op.position < size_);
+
+          const auto [node, index] = seek(cursor, op.position);
+          op.value = node[index];
+          break;
+        }
+
+        case LariatOp::find: {
+          const usize found = index_of(op.value);
+          op.position = found == npos ? size_ : found;
+          break;
+        }
+
+        case LariatOp::compact: compact_pending = true; break;
+      }
+    }
+  } catch (...) {
+    unlink_empty();
+    throw;
   }
 
-  next->count = node.count - sep_index;
-  node.count -= next->count;
+  unlink_empty();
 
-  // book keeping
-  while (tail_->next) {
-    tail_ = tail_->next;
+  if (compact_pending) {
+    compact();
   }
+  check_occupancy();
 }
 
-template<typename T, usize Size>
-auto Lariat<T, Size>::find_element(const usize i) const -> FindResult {
+template<typename T, usize Size, typename Policy>
+template<typename Index>
+auto Lariat<T, Size, Policy>::gather(
+  const Index* indices,
+  const usize n,
+  T* out
+) const -> void {
+  Cursor cursor{head_, 0};
+
+  for (const usize j: sorted_order(indices, n)) {
+    const auto [node, index] = seek(cursor, static_cast<usize>(indices[j]));
+    out[j] = node[index];
+  }
+}
 
-  if (i > size()) {
-    throw LariatException{LariatException::E_BAD_INDEX};
+template<typename T, usize Size, typename Policy>
+template<typename Index>
+auto Lariat<T, Size, Policy>::scatter(
+  const Index* indices,
+  const T* values,
+  const usize n
+) -> void {
+  Cursor cursor{head_, 0};
+
+  for (const usize j: sorted_order(indices, n)) {
+    const usize global = static_cast<usize>(indices[j]);
+    const auto [node, index] = seek(cursor, global);
+
+    index_erase(node, index, global);
+    node[index] = values[j];
+    index_insert(node, index, global);
   }
+}
 
-  usize index{i};
+template<typename T, usize Size, typename Policy>
+template<typename Index>
+auto Lariat<T, Size, Policy>::sorted_order(
+  const Index* indices,
+  const usize n
+) const -> std::vector<usize> {
+  static_assert(std::is_integral_v<Index>, "Indices must be integers");
+
+  std::vector<usize> order(n);
+  bool sorted{true};
+
+  for (usize j = 0; j < n; j++) {
+    Policy::Checks::check(static_cast<usize>(indices[j]) < size_);
+    order[j] = j;
+    sorted = sorted and (j == 0 or indices[j - 1] <= indices[j]);
+  }
 
-  for (LNode* node = head_; node; node = node->next) {
-    if (index < node->count) {
-      return {*node, index};
+  if (not sorted) {
+    // checked indices are not negative, so Index order is usize order
+    std::sort(order.begin(), order.end(), [indices](usize a, usize b) {
+      return indices[a] < indices[b] or (indices[a] == indices[b] and a < b);
+    });
+  }
+
+  return order;
+}
+
+template<typename T, usize Size, typename Policy>
+template<typename Fn>
+auto Lariat<T, Size, Policy>::for_each_chunk(Fn&& fn) const -> void {
+  for (const LNode* node = head_; node; node = node->next) {
+    for (usize i = 0; i < node->count;) {
+      const usize run = node->run_length(i);
+      fn(LariatSpan<const T>{&(*node)[i], run});
+      i += run;
     }
+  }
+}
 
-    index -= node->count;
+template<typename T, usize Size, typename Policy>
+template<typename Fn>
+auto Lariat<T, Size, Policy>::for_each_chunk(Fn&& fn) -> void {
+  for (LNode* node = head_; node; node = node->next) {
+    for (usize i = 0; i < node->count;) {
+      const usize run = node->run_length(i);
+      fn(LariatSpan<T>{&(*node)[i], run});
+      i += run;
+    }
   }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::chunks() const noexcept -> ChunkRange<const T> {
+  return {{head_, 0}};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::chunks() noexcept -> ChunkRange<T> {
+  return {{head_, 0}};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::chunk_at(const usize i) const
+  -> LariatSpan<const T> {
+  Policy::Checks::check(i < size());
+
+  const auto [node, index] = find_element(i);
+  return {&node[index], node.run_length(index)};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::chunk_at(const usize i) -> LariatSpan<T> {
+  Policy::Checks::check(i < size());
+
+  const auto [node, index] = find_element(i);
+  return {&node[index], node.run_length(index)};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::clear() -> void {
+  while (head_) {
+    LNode* next = head_->next;
+    destroy_node(head_);
+    head_ = next;
+  }
+  tail_ = nullptr;
+  size_ = 0;
+  nodecount_ = 0;
+  asize_ = 0;
+
+  if constexpr (Policy::Summary::enabled) {
+    directory_.fresh = false;
+  }
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (index_) {
+      index_->entries.clear();
+    }
+  }
+
+  if (handles_) {
+    for (usize slot = 1; slot < handles_->slots.size(); slot++) {
+      if (handles_->slots[slot].node) {
+        retire_handle(static_cast<u32>(slot));
+      }
+    }
+    handles_->nodes.clear();
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::check_occupancy() -> void {
+  if constexpr (Policy::Occupancy::automatic) {
+    using Occupancy = typename Policy::Occupancy;
+
+    // fill factors compared in percent without dividing
+    const usize filled = size_ * 100;
+    if (filled >= nodecount_ * Size * Occupancy::high_percent) {
+      compact_state_.armed = true;
+      return;
+    }
+
+    // compacting must free a node, or small lists would compact forever
+    if (not compact_state_.armed
+        or filled >= nodecount_ * Size * Occupancy::low_percent
+        or (size_ + Size - 1) / Size >= nodecount_) {
+      return;
+    }
+
+    compact();
+    compact_state_.armed =
+      size_ * 100 >= nodecount_ * Size * Occupancy::high_percent;
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::enable_index() -> void {
+  static_assert(
+    LariatIsHashable<T>::value,
+    "Value index requires std::hash<T>"
+  );
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (not index_) {
+      index_ = new ValueIndex{};
+    }
+    rebuild_index();
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::disable_index() -> void {
+  if constexpr (LariatIsHashable<T>::value) {
+    delete index_;
+    index_ = nullptr;
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::is_indexed() const noexcept -> bool {
+  return index_ != nullptr;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::handle(const usize index) -> LariatHandle {
+  Policy::Checks::check(index < size_);
+
+  if (not handles_) {
+    handles_ = new HandleTable{};
+  }
+
+  auto& slots = handles_->slots;
+  u32 slot = handles_->free_head;
+  if (slot != 0) {
+    handles_->free_head = slots[slot].next_free;
+  } else {
+    slot = static_cast<u32>(slots.size());
+    slots.push_back({nullptr, 0, 1, 0});
+  }
+
+  const auto [node, local] = find_element(index);
+  slots[slot].node = &node;
+  slots[slot].index = local;
+  handles_->nodes[&node].push_back(slot);
+
+  return {slot, slots[slot].generation};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::release(const LariatHandle handle) -> void {
+  const usize slot = live_slot(handle);
+  if (slot == npos) {
+    return;
+  }
+
+  const auto found = handles_->nodes.find(handles_->slots[slot].node);
+  std::vector<u32>& slots = found->second;
+  *std::find(slots.begin(), slots.end(), slot) = slots.back();
+  slots.pop_back();
+  if (slots.empty()) {
+    handles_->nodes.erase(found);
+  }
+
+  retire_handle(static_cast<u32>(slot));
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::is_valid(const LariatHandle handle)
+  const noexcept -> bool {
+  return live_slot(handle) != npos;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::index_of(const LariatHandle handle) const
+  -> usize {
+  const usize slot = live_slot(handle);
+  if (slot == npos) {
+    return npos;
+  }
+
+  const typename HandleTable::Slot& found = handles_->slots[slot];
+  usize index = found.index;
+  for (const LNode* node = found.node->prev; node; node = node->prev) {
+    index += node->count;
+  }
+  return index;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::get(const LariatHandle handle) -> T& {
+  const usize slot = live_slot(handle);
+  if (slot == npos) {
+    throw LariatException{LariatException::E_BAD_HANDLE};
+  }
+
+  const typename HandleTable::Slot& found = handles_->slots[slot];
+  return (*found.node)[found.index];
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::get(const LariatHandle handle) const
+  -> const T& {
+  const usize slot = live_slot(handle);
+  if (slot == npos) {
+    throw LariatException{LariatException::E_BAD_HANDLE};
+  }
+
+  const typename HandleTable::Slot& found = handles_->slots[slot];
+  return std::as_const(*found.node)[found.index];
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::rebuild_index() -> void {
+  if constexpr (Policy::Summary::enabled) {
+    for (LNode* node = head_; node; node = node->next) {
+      summarize(*node);
+    }
+    directory_.fresh = false;
+  }
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (not index_) {
+      return;
+    }
+
+    using Entry = typename ValueIndex::Entry;
+
+    index_->entries.clear();
+    index_->entries.reserve(size_);
+
+    usize offset = 0;
+    for (LNode* node = head_; node; node = node->next) {
+      node->offset = offset;
+      for (usize j = 0; j < node->count; j++) {
+        const auto [entry, inserted] =
+          index_->entries.try_emplace((*node)[j], Entry{node, 1});
+        if (not inserted) {
+          entry->second.count++;
+        }
+      }
+      offset += node->count;
+    }
+
+    index_->clean_below = static_cast<usize>(-1);
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::index_memory() const -> usize {
+  if constexpr (LariatIsHashable<T>::value) {
+    if (not index_) {
+      return 0;
+    }
+
+    using Entry = typename ValueIndex::Entry;
+
+    // one heap node per entry (value, payload, chain pointer, cached hash) and
+    // one pointer per bucket
+    constexpr usize entry_bytes =
+      sizeof(T) + sizeof(Entry) + sizeof(void*) + sizeof(usize);
+
+    return sizeof(ValueIndex) + index_->entries.size() * entry_bytes
+         + index_->entries.bucket_count() * sizeof(void*);
+  } else {
+    return 0;
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::summary() const -> SummaryValue {
+  static_assert(Policy::Summary::enabled, "Policy has no node summary");
+
+  refresh_directory();
+  return directory_.tree.empty() ? Policy::Summary::identity()
+                                 : directory_.tree[1].total;
+}
+
+template<typename T, usize Size, typename Policy>
+template<typename Pred>
+auto Lariat<T, Size, Policy>::seek_summary(Pred pred) const -> SummaryHit {
+  static_assert(Policy::Summary::enabled, "Policy has no node summary");
+
+  refresh_directory();
+  const auto& tree = directory_.tree;
+  if (tree.empty() or not pred(tree[1].items, tree[1].total)) {
+    return {end(), size_, summary()};
+  }
+
+  // pred is monotone, so it holds for the totals through the left child or
+  // else the node is in the right one
+  usize items{0};
+  SummaryValue before = Policy::Summary::identity();
+  usize i{1};
+  while (i < directory_.leaves) {
+    const usize left = 2 * i;
+    const usize through_items = items + tree[left].items;
+    SummaryValue through = Policy::Summary::combine(before, tree[left].total);
+    if (pred(through_items, std::as_const(through))) {
+      i = left;
+    } else {
+      items = through_items;
+      before = std::move(through);
+      i = left + 1;
+    }
+  }
+
+  LNode* const node = directory_.nodes[i - directory_.leaves];
+  return {const_iterator{this, node, 0}, items, std::move(before)};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::range_query(
+  const usize first,
+  const usize last
+) const -> SummaryValue {
+  static_assert(Policy::Summary::enabled, "Policy has no node summary");
+  Policy::Checks::check(first <= last and last <= size_);
+
+  SummaryValue total = Policy::Summary::identity();
+  if (first == last) {
+    return total;
+  }
+
+  const SummaryHit hit = seek_summary([first](usize items, const auto&) {
+    return items > first;
+  });
+
+  const LNode* node = hit.first.node_;
+  usize index = first - hit.offset;
+  for (usize left = last - first; left > 0; node = node->next) {
+    const usize n = std::min(node->count - index, left);
+    if (n == node->count) {
+      total = Policy::Summary::combine(std::move(total), node->summary);
+    } else {
+      for (usize j = index; j < index + n; j++) {
+        Policy::Summary::add(total, (*node)[j]);
+      }
+    }
+
+    left -= n;
+    index = 0;
+  }
+
+  return total;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::stats() const -> LariatStatsReport {
+  LariatStatsReport report{};
+
+  if constexpr (Policy::Stats::enabled) {
+    report.counting = true;
+    report.counters = stats_;
+  }
+
+  report.size = size_;
+  report.node_size = Size;
+  report.nodes = nodecount_;
+  report.ideal_nodes = (size_ + Size - 1) / Size;
+
+  for (const LNode* node = head_; node; node = node->next) {
+    if (node->count == 0) {
+      report.empty_nodes++;
+    }
+
+    const usize bucket = node->count * LariatStatsReport::fill_buckets / Size;
+    report.fill_histogram[std::min(
+      bucket,
+      LariatStatsReport::fill_buckets - 1
+    )]++;
+  }
+
+  if (size_) {
+    usize heap_nodes = nodecount_;
+    if constexpr (Policy::inline_node) {
+      heap_nodes -= inline_.used ? 1 : 0;
+    }
+
+    const usize bytes =
+      sizeof(*this) + heap_nodes * sizeof(LNode) + index_memory();
+    report.bytes_per_element =
+      static_cast<double>(bytes) / static_cast<double>(size_);
+  }
+
+  return report;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::reset_stats() noexcept -> void {
+  stats_ = typename Policy::Stats{};
+}
+
+inline auto LariatThrowChecks::check(const bool valid) -> void {
+  if (not valid) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+}
+
+inline auto LariatAssertChecks::check(
+  [[maybe_unused]] const bool valid
+) noexcept -> void {
+  assert(valid and "Subscript is out of range");
+}
+
+inline auto LariatStatsReport::write_json(std::ostream& os) const -> void {
+  os << "{\"counting\": " << (counting ? "true" : "false")
+     << ", \"splits\": " << counters.splits
+     << ", \"shifted_elements\": " << counters.shifted_elements
+     << ", \"lookups\": " << counters.lookups
+     << ", \"node_hops\": " << counters.node_hops
+     << ", \"allocations\": " << counters.allocations
+     << ", \"frees\": " << counters.frees
+     << ", \"compactions\": " << counters.compactions << ", \"size\": " << size
+     << ", \"node_size\": " << node_size << ", \"nodes\": " << nodes
+     << ", \"ideal_nodes\": " << ideal_nodes
+     << ", \"empty_nodes\": " << empty_nodes << ", \"fill_histogram\": [";
+
+  for (usize i = 0; i < fill_buckets; i++) {
+    os << (i ? ", " : "") << fill_histogram[i];
+  }
+
+  os << "], \"bytes_per_element\": " << bytes_per_element << "}";
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::save(std::ostream& os) const -> void {
+  using Serializer = LariatSerializer<T>;
+
+  const LariatSnapshotHeader header{
+    {'L', 'R', 'A', 'T'},
+    snapshot_version,
+    Serializer::tag,
+    static_cast<u32>(sizeof(T)),
+    Size,
+    size_,
+    nodecount_,
+  };
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  for (const LNode* node = head_; node; node = node->next) {
+    const u64 count = node->count;
+    os.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    node->for_each_segment([&os](const T* values, usize n) {
+      Serializer::write(os, values, n);
+    });
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::load(std::istream& is) -> void {
+  using Serializer = LariatSerializer<T>;
+
+  clear();
+
+  LariatSnapshotHeader header{};
+  is.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (not is or std::memcmp(header.magic, "LRAT", sizeof(header.magic)) != 0) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      "Not a Lariat snapshot"
+    };
+  }
+
+  if (header.version != snapshot_version) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      "Unsupported snapshot version " + std::to_string(header.version)
+    };
+  }
+
+  if (header.type_tag != Serializer::tag or header.value_size != sizeof(T)) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      "Snapshot element type does not match"
+    };
+  }
+
+  try {
+    // blocks larger than Size (snapshot from a bigger Lariat) are spread over
+    // several nodes, each filled by a single read
+    for (u64 block = 0; block < header.node_count; block++) {
+      u64 count{0};
+      is.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+      if (not is or count > header.node_size or size_ + count > header.size) {
+        throw LariatException{
+          LariatException::E_DATA_ERROR,
+          "Corrupt snapshot block"
+        };
+      }
+
+      while (count > 0) {
+        LNode* const node = make_node(tail_, nullptr);
+        if (tail_) {
+          tail_->next = node;
+        } else {
+          head_ = node;
+        }
+        tail_ = node;
+
+        const usize n = std::min(static_cast<usize>(count), Size);
+        Serializer::read(is, node->set_front(n), n);
+        if (not is) {
+          throw LariatException{
+            LariatException::E_DATA_ERROR,
+            "Truncated snapshot"
+          };
+        }
+
+        size_ += node->count;
+        count -= node->count;
+      }
+    }
+
+    if (size_ != header.size) {
+      throw LariatException{
+        LariatException::E_DATA_ERROR,
+        "Snapshot size does not match its blocks"
+      };
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+
+  rebuild_index();
+}
+
+template<typename T, typename Enable>
+auto LariatSerializer<T, Enable>::write(
+  std::ostream& os,
+  const T* values,
+  const usize count
+) -> void {
+  os.write(
+    reinterpret_cast<const char*>(values),
+    static_cast<std::streamsize>(count * sizeof(T))
+  );
+}
+
+template<typename T, typename Enable>
+auto LariatSerializer<T, Enable>::read(
+  std::istream& is,
+  T* values,
+  const usize count
+) -> void {
+  is.read(
+    reinterpret_cast<char*>(values),
+    static_cast<std::streamsize>(count * sizeof(T))
+  );
+}
+
+template<typename T, usize Size>
+auto LariatWindowStorage<T, Size>::insert(
+  const usize index,
+  const T& value
+) noexcept(
+  std::is_nothrow_move_assignable_v<T> and std::is_nothrow_copy_assignable_v<T>
+) -> usize {
+  const usize before = index;
+  const usize after = count - index;
+  const bool move_front = before <= after;
+
+  // the shorter side has no room left, recenter so that both ends have some
+  if (move_front ? start == 0 : start + count == Size) {
+    slide((Size - count) / 2);
+  }
+
+  usize moved{0};
+  if (start > 0 and (move_front or start + count == Size)) {
+    std::move(slots + start, slots + start + index, slots + start - 1);
+    start--;
+    moved = before;
+  } else {
+    std::move_backward(
+      slots + start + index,
+      slots + start + count,
+      slots + start + count + 1
+    );
+    moved = after;
+  }
+
+  slots[start + index] = value;
+  count++;
+  return moved;
+}
+
+template<typename T, usize Size>
+auto LariatWindowStorage<T, Size>::erase(const usize index) noexcept(
+  std::is_nothrow_move_assignable_v<T>
+) -> usize {
+  T* const first = slots + start;
+  const usize before = index;
+  const usize after = count - index - 1;
+
+  count--;
+
+  if (before < after) {
+    std::move_backward(first, first + index, first + index + 1);
+    start++;
+    return before;
+  }
+
+  std::move(first + index + 1, first + count + 1, first + index);
+  return after;
+}
+
+template<typename T, usize Size>
+auto LariatWindowStorage<T, Size>::split_to(
+  const usize from,
+  LariatWindowStorage& dest
+) noexcept(std::is_nothrow_move_assignable_v<T>) -> void {
+  std::move(slots + start + from, slots + start + count, dest.slots);
+  dest.start = 0;
+  dest.count = static_cast<Count>(count - from);
+  count = static_cast<Count>(from);
+}
+
+template<typename T, usize Size>
+auto LariatWindowStorage<T, Size>::slide(const usize new_start) noexcept(
+  std::is_nothrow_move_assignable_v<T>
+) -> usize {
+  if (new_start < start) {
+    std::move(slots + start, slots + start + count, slots + new_start);
+  } else if (new_start > start) {
+    std::move_backward(
+      slots + start,
+      slots + start + count,
+      slots + new_start + count
+    );
+  } else {
+    return 0;
+  }
+
+  start = static_cast<Count>(new_start);
+  return count;
+}
+
+template<typename T, usize Size>
+auto LariatWindowStorage<T, Size>::set_front(const usize n) noexcept -> T* {
+  start = 0;
+  count = static_cast<Count>(n);
+  return slots;
+}
+
+template<typename T, usize Size>
+template<typename Fn>
+auto LariatWindowStorage<T, Size>::for_each_segment(Fn&& fn) const -> void {
+  fn(static_cast<const T*>(slots + start), count);
+}
+
+template<typename T, usize Size>
+auto LariatGapStorage<T, Size>::insert(
+  const usize index,
+  const T& value
+) noexcept(
+  std::is_nothrow_move_assignable_v<T> and std::is_nothrow_copy_assignable_v<T>
+) -> usize {
+  const usize moved = move_gap(index);
+  slots[gap++] = value;
+  count++;
+  return moved;
+}
+
+template<typename T, usize Size>
+auto LariatGapStorage<T, Size>::erase(const usize index) noexcept(
+  std::is_nothrow_move_assignable_v<T>
+) -> usize {
+  usize moved{0};
+
+  // the item is absorbed by whichever end of the gap it is next to
+  if (index < gap) {
+    moved = move_gap(index + 1);
+    gap--;
+  } else {
+    moved = move_gap(index);
+  }
+
+  count--;
+  return moved;
+}
+
+template<typename T, usize Size>
+auto LariatGapStorage<T, Size>::split_to(
+  const usize from,
+  LariatGapStorage& dest
+) noexcept(std::is_nothrow_move_assignable_v<T>) -> void {
+  // everything after the gap is then exactly [from, count)
+  move_gap(from);
+  std::move(slots + gap + (Size - count), slots + Size, dest.slots);
+  dest.count = static_cast<Count>(count - from);
+  dest.gap = dest.count;
+  count = static_cast<Count>(from);
+}
+
+template<typename T, usize Size>
+auto LariatGapStorage<T, Size>::slide(const usize new_start) noexcept(
+  std::is_nothrow_move_assignable_v<T>
+) -> usize {
+  return move_gap(new_start == 0 ? count : 0);
+}
+
+template<typename T, usize Size>
+auto LariatGapStorage<T, Size>::set_front(const usize n) noexcept -> T* {
+  gap = static_cast<Count>(n);
+  count = static_cast<Count>(n);
+  return slots;
+}
+
+template<typename T, usize Size>
+template<typename Fn>
+auto LariatGapStorage<T, Size>::for_each_segment(Fn&& fn) const -> void {
+  if (gap > 0) {
+    fn(static_cast<const T*>(slots), gap);
+  }
+  if (count > gap) {
+    fn(static_cast<const T*>(slots + gap + (Size - count)), count - gap);
+  }
+}
+
+template<typename T, usize Size>
+auto LariatGapStorage<T, Size>::move_gap(const usize index) noexcept(
+  std::is_nothrow_move_assignable_v<T>
+) -> usize {
+  const usize gap_end = gap + (Size - count);
+
+  if (index < gap) {
+    std::move_backward(slots + index, slots + gap, slots + gap_end);
+  } else if (index > gap) {
+    std::move(slots + gap_end, slots + gap_end + (index - gap), slots + gap);
+  } else {
+    return 0;
+  }
+
+  const usize moved = index < gap ? gap - index : index - gap;
+  gap = static_cast<Count>(index);
+  return moved;
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::insert(
+  const usize index,
+  const T& value
+) noexcept(
+  std::is_nothrow_move_assignable_v<T> and std::is_nothrow_copy_assignable_v<T>
+) -> usize {
+  usize moved{0};
+
+  if (count != used) {
+    // a dead slot right before the item takes the value without moving
+    const usize slot = index == count ? used : slot_of(index);
+    if (slot > 0 and not is_live(slot - 1)) {
+      slots[slot - 1] = value;
+      live[(slot - 1) / 64] |= u64{1} << ((slot - 1) % 64);
+      count++;
+      return 0;
+    }
+
+    moved = purge();
+  }
+
+  std::move_backward(slots + index, slots + count, slots + count + 1);
+  slots[index] = value;
+  count++;
+  used++;
+  live[(used - 1) / 64] |= u64{1} << ((used - 1) % 64);
+  return moved + (count - 1 - index);
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::erase(const usize index)
+  noexcept(std::is_nothrow_move_assignable_v<T>) -> usize {
+  const usize slot = slot_of(index);
+  live[slot / 64] &= ~(u64{1} << (slot % 64));
+  count--;
+
+  // dead slots at the end are just free
+  while (used > 0 and not is_live(used - 1)) {
+    used--;
+  }
+
+  if ((usize{used} - count) * 100 > Size * DeadPercent) {
+    return purge();
+  }
+
+  return 0;
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::split_to(
+  const usize from,
+  LariatTombstoneStorage& dest
+) noexcept(std::is_nothrow_move_assignable_v<T>) -> void {
+  purge();
+  std::move(slots + from, slots + count, dest.slots);
+  dest.mark_front(count - from);
+  mark_front(from);
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::slide(usize) noexcept(
+  std::is_nothrow_move_assignable_v<T>
+) -> usize {
+  return purge();
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::set_front(const usize n)
+  noexcept -> T* {
+  mark_front(n);
+  return slots;
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::purge() noexcept(
+  std::is_nothrow_move_assignable_v<T>
+) -> usize {
+  if (count == used) {
+    return 0;
+  }
+
+  usize write{0};
+  for (usize slot = 0; slot < used; slot++) {
+    if (is_live(slot)) {
+      if (write != slot) {
+        slots[write] = std::move(slots[slot]);
+      }
+      write++;
+    }
+  }
+
+  mark_front(count);
+  return count;
+}
+
+template<typename T, usize Size, usize DeadPercent>
+template<typename Fn>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::for_each_segment(Fn&& fn)
+  const -> void {
+  usize slot{0};
+  while (slot < used) {
+    for (; slot < used and not is_live(slot); slot++) {}
+
+    const usize first = slot;
+    for (; slot < used and is_live(slot); slot++) {}
+
+    if (slot > first) {
+      fn(static_cast<const T*>(slots + first), slot - first);
+    }
+  }
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::run_length(usize index)
+  const noexcept -> usize {
+  if (count == used) {
+    return count - index;
+  }
+
+  const usize first = slot_of(index);
+  usize slot = first + 1;
+  for (; slot < used and is_live(slot); slot++) {}
+  return slot - first;
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::slot_of(usize index) const
+  noexcept -> usize {
+  if (count == used) {
+    return index;
+  }
+
+  for (usize word = 0;; word++) {
+    const usize in_word = lariat_popcount(live[word]);
+    if (index < in_word) {
+      return word * 64 + lariat_select_bit(live[word], index);
+    }
+    index -= in_word;
+  }
+}
+
+template<typename T, usize Size, usize DeadPercent>
+auto LariatTombstoneStorage<T, Size, DeadPercent>::mark_front(const usize n)
+  noexcept -> void {
+  for (usize word = 0; word < words; word++) {
+    const usize first = word * 64;
+    live[word] = n >= first + 64 ? ~u64{0}
+               : n > first       ? (u64{1} << (n - first)) - 1
+                                 : 0;
+  }
+  count = static_cast<Count>(n);
+  used = static_cast<Count>(n);
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::LNode::is_full() const noexcept -> bool {
+  return this->count == Size;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::make_node(LNode* prev, LNode* next) const
+  -> LNode* {
+  if constexpr (Policy::inline_node) {
+    if (not inline_.used) {
+      LNode* const node = &inline_.node;
+      inline_.used = true;
+      node->set_front(0);
+      node->prev = prev;
+      node->next = next;
+      node->offset = static_cast<usize>(-1);
+      node->summary = Policy::Summary::identity();
+      nodecount_++;
+      if constexpr (Policy::Summary::enabled) {
+        directory_.fresh = false;
+      }
+      return node;
+    }
+  }
+
+  try {
+    LNode* node = new LNode();
+    stats_.on_allocate();
+    node->prev = prev;
+    node->next = next;
+    node->offset = static_cast<usize>(-1);
+    nodecount_++;
+    if constexpr (Policy::Summary::enabled) {
+      directory_.fresh = false;
+    }
+    return node;
+  } catch (const std::bad_alloc&) {
+    throw LariatException{LariatException::E_NO_MEMORY};
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::destroy_node(LNode* node) const noexcept
+  -> void {
+  nodecount_--;
+  if constexpr (Policy::Summary::enabled) {
+    directory_.fresh = false;
+  }
+
+  if constexpr (Policy::inline_node) {
+    if (node == &inline_.node) {
+      inline_.used = false;
+      return;
+    }
+  }
+
+  delete node;
+  stats_.on_free();
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::take(Lariat& rhs) -> void {
+  head_ = std::exchange(rhs.head_, nullptr);
+  tail_ = std::exchange(rhs.tail_, nullptr);
+  size_ = std::exchange(rhs.size_, 0);
+  nodecount_ = std::exchange(rhs.nodecount_, 0);
+  asize_ = std::exchange(rhs.asize_, 0);
+  index_ = std::exchange(rhs.index_, nullptr);
+  handles_ = std::exchange(rhs.handles_, nullptr);
+  stats_ = rhs.stats_;
+
+  if constexpr (Policy::Summary::enabled) {
+    directory_.fresh = false;
+    rhs.directory_.fresh = false;
+  }
+
+  if constexpr (Policy::inline_node) {
+    if (not rhs.inline_.used) {
+      return;
+    }
+
+    // the inline node cannot change owner, its contents move instead
+    LNode& from = rhs.inline_.node;
+    LNode& to = inline_.node;
+    using Storage = typename Policy::template Storage<T, Size>;
+    static_cast<Storage&>(to) = std::move(static_cast<Storage&>(from));
+    to.prev = from.prev;
+    to.next = from.next;
+
+    if (to.prev) {
+      to.prev->next = &to;
+    } else {
+      head_ = &to;
+    }
+
+    if (to.next) {
+      to.next->prev = &to;
+    } else {
+      tail_ = &to;
+    }
+
+    inline_.used = true;
+    rhs.inline_.used = false;
+
+    if (handles_) {
+      const auto found = handles_->nodes.find(&from);
+      if (found != handles_->nodes.end()) {
+        std::vector<u32> slots = std::move(found->second);
+        handles_->nodes.erase(found);
+        for (const u32 slot: slots) {
+          handles_->slots[slot].node = &to;
+        }
+        handles_->nodes[&to] = std::move(slots);
+      }
+    }
+
+    // entries may point at the node of rhs
+    rebuild_index();
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+template<typename S, usize OtherSize, typename OtherPolicy>
+auto Lariat<T, Size, Policy>::convert_from(
+  const Lariat<S, OtherSize, OtherPolicy>& rhs
+) -> void {
+  using Node = typename Lariat<S, OtherSize, OtherPolicy>::LNode;
+
+  // a run of source items and where it goes
+  struct Piece {
+    const S* from;
+    usize count;
+    T* to;
+  };
+
+  constexpr bool parallel = Policy::convert_threads > 1
+                        and std::is_arithmetic_v<S>
+                        and std::is_arithmetic_v<T>;
+
+  const usize total = rhs.size_;
+  if (total == 0) {
+    return;
+  }
+
+  try {
+    // the nodes are filled the way push_back leaves them: halves of split
+    // nodes, then whatever remains in the tail
+    const usize keep = (Size + 2) / 2;
+    usize halves = total > Size ? (total - Size + keep - 1) / keep : 0;
+
+    for (usize left = total; left > 0;) {
+      const usize fill = halves > 0 ? keep : left;
+      LNode* const node = make_node(tail_, nullptr);
+      node->set_front(fill);
+
+      if (tail_) {
+        tail_->next = node;
+      } else {
+        head_ = node;
+      }
+      tail_ = node;
+
+      halves -= halves > 0 ? 1 : 0;
+      left -= fill;
+    }
+    size_ = total;
+
+    std::vector<Piece> pieces;
+    LNode* dest = head_;
+    usize written{0};
+
+    for (const Node* node = rhs.head_; node; node = node->next) {
+      node->for_each_segment([&](const S* from, usize count) {
+        while (count > 0) {
+          if (written == dest->count) {
+            dest = dest->next;
+            written = 0;
+          }
+
+          const usize run = std::min(count, dest->count - written);
+          if (parallel and total >= Policy::convert_parallel_min) {
+            pieces.push_back({from, run, dest->slots + written});
+          } else {
+            lariat_convert(from, run, dest->slots + written);
+          }
+
+          from += run;
+          count -= run;
+          written += run;
+        }
+      });
+    }
+
+    if constexpr (parallel) {
+      const usize threads = Policy::convert_threads;
+      const auto convert_share = [&pieces, threads](usize share) {
+        const usize first = pieces.size() * share / threads;
+        const usize last = pieces.size() * (share + 1) / threads;
+        for (usize i = first; i < last; i++) {
+          lariat_convert(pieces[i].from, pieces[i].count, pieces[i].to);
+        }
+      };
+
+      std::vector<std::thread> workers;
+      workers.reserve(threads - 1);
+      try {
+        for (usize share = 1; share < threads; share++) {
+          workers.emplace_back(convert_share, share);
+        }
+      } catch (...) {
+        for (std::thread& worker: workers) {
+          worker.join();
+        }
+        throw;
+      }
+
+      convert_share(0);
+      for (std::thread& worker: workers) {
+        worker.join();
+      }
+    }
+  } catch (...) {
+    clear();
+    throw;
+  }
+
+  rebuild_index();
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::unlink(LNode& node) noexcept -> void {
+  if (node.prev) {
+    node.prev->next = node.next;
+  } else {
+    head_ = node.next;
+  }
+
+  if (node.next) {
+    node.next->prev = node.prev;
+  } else {
+    tail_ = node.prev;
+  }
+
+  destroy_node(&node);
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::split(LNode& node) -> void {
+  split_at(node, (node.count + 1) / 2);
+
+  // only push_front splits a node this way, the half that stays is moved to
+  // the back of its array so the following pushes find room in front
+  stats_.on_shift(node.slide(Size - node.count));
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::split_at(LNode& node, const usize index)
+  -> void {
+  LNode* const next = make_node(&node, node.next);
+  stats_.on_split();
+
+  if (node.next) {
+    node.next->prev = next;
+  } else {
+    tail_ = next;
+  }
+  node.next = next;
+
+  node.split_to(index, *next);
+  index_split(node, *next);
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::insert_at(
+  LNode& node,
+  const usize index,
+  const usize global,
+  const T& value
+) -> FindResult {
+  if (node.is_full()) {
+    const FindResult result = split_insert(node, index, value);
+    size_++;
+    index_insert(result.node, result.index, global);
+    handles_insert(result.node, result.index);
+    return result;
+  }
+
+  stats_.on_shift(node.insert(index, value));
+  size_++;
+
+  index_insert(node, index, global);
+  handles_insert(node, index);
+  return {node, index};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::split_insert(
+  LNode& node,
+  const usize index,
+  const T& value
+) -> FindResult {
+  LNode* const next = make_node(&node, node.next);
+  stats_.on_split();
+
+  if (node.next) {
+    node.next->prev = next;
+  } else {
+    tail_ = next;
+  }
+  node.next = next;
+
+  // virtual layout is node[0, index) value node[index, count)
+  const usize total = node.count + 1;
+  const usize sep_index = (total + 1) / 2;
+
+  if (index < sep_index) {
+    node.split_to(sep_index - 1, *next);
+    index_split(node, *next);
+
+    stats_.on_shift(node.insert(index, value));
+    return {node, index};
+  }
+
+  node.split_to(sep_index, *next);
+  index_split(node, *next);
+
+  stats_.on_shift(next->insert(index - sep_index, value));
+  return {*next, index - sep_index};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::remove_at(
+  LNode& node,
+  const usize index,
+  const usize global,
+  const bool unlink_empty
+) -> void {
+  index_erase(node, index, global);
+  handles_erase(node, index);
+
+  stats_.on_shift(node.erase(index));
+  size_--;
+
+  if (unlink_empty and node.count == 0) {
+    unlink(node);
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::index_insert(
+  LNode& node,
+  const usize index,
+  const usize global
+) -> void {
+  if constexpr (Policy::Summary::enabled) {
+    Policy::Summary::add(node.summary, node[index]);
+    update_directory(node, node.count);
+  }
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (not index_) {
+      return;
+    }
+
+    using Entry = typename ValueIndex::Entry;
+
+    index_->clean_below = std::min(index_->clean_below, global);
+
+    const auto [entry, inserted] =
+      index_->entries.try_emplace(node[index], Entry{&node, 1});
+    if (inserted) {
+      return;
+    }
+
+    Entry& found = entry->second;
+    found.count++;
+
+    // either an earlier copy in the same node or this one is the first
+    if (found.node == &node) {
+      return;
+    }
+
+    // a trusted offset starts before global, so that node comes first
+    // without recounting the offsets
+    if (global != 0 and found.node->offset < index_->clean_below) {
+      return;
+    }
+
+    if (global == 0 or index_offset(node) < index_offset(*found.node)) {
+      found.node = &node;
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::index_erase(
+  LNode& node,
+  const usize index,
+  const usize global
+) -> void {
+  if constexpr (Policy::Summary::enabled) {
+    if constexpr (Policy::Summary::invertible) {
+      Policy::Summary::remove(node.summary, node[index]);
+    } else {
+      summarize(node, index);
+    }
+
+    // the item is only taken out of the node after this
+    update_directory(node, node.count - 1);
+  }
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (not index_) {
+      return;
+    }
+
+    index_->clean_below = std::min(index_->clean_below, global);
+
+    const T& value = node[index];
+    const auto entry = index_->entries.find(value);
+    if (entry == index_->entries.end()) {
+      return;
+    }
+
+    typename ValueIndex::Entry& found = entry->second;
+    if (--found.count == 0) {
+      index_->entries.erase(entry);
+      return;
+    }
+
+    // a copy in an earlier node is the first occurrence
+    if (found.node != &node) {
+      return;
+    }
+
+    for (usize j = 0; j < node.count; j++) {
+      if (j != index and node[j] == value) {
+        return;
+      }
+    }
+
+    // the erased value was the first occurrence, the next one is further down
+    for (LNode* next = node.next; next; next = next->next) {
+      for (usize j = 0; j < next->count; j++) {
+        if ((*next)[j] == value) {
+          found.node = next;
+          return;
+        }
+      }
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::fill_node(
+  LNode& node,
+  const usize index,
+  const T* values,
+  const usize n
+) -> void {
+  const usize count = node.count;
+  usize moved = node.slide(0);
+
+  T* const slots = node.set_front(count + n);
+  std::move_backward(slots + index, slots + count, slots + count + n);
+  std::copy_n(values, n, slots + index);
+  moved += count - index;
+
+  stats_.on_shift(moved);
+  size_ += n;
+
+  if constexpr (Policy::Summary::enabled) {
+    for (usize j = index; j < index + n; j++) {
+      Policy::Summary::add(node.summary, node[j]);
+    }
+    update_directory(node, node.count);
+  }
+
+  handles_insert(node, index, n);
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::drain_node(
+  LNode& node,
+  const usize index,
+  const usize n
+) -> void {
+  handles_erase(node, index, n);
+
+  const usize count = node.count;
+  usize moved = node.slide(0);
+
+  T* const slots = node.set_front(count);
+  std::move(slots + index + n, slots + count, slots + index);
+  node.set_front(count - n);
+  moved += count - index - n;
+
+  stats_.on_shift(moved);
+  size_ -= n;
+
+  if constexpr (Policy::Summary::enabled) {
+    summarize(node);
+    update_directory(node, node.count);
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::handles_insert(
+  LNode& node,
+  const usize index,
+  const usize n
+) -> void {
+  if (not handles_) {
+    return;
+  }
+
+  const auto found = handles_->nodes.find(&node);
+  if (found == handles_->nodes.end()) {
+    return;
+  }
+
+  for (const u32 slot: found->second) {
+    usize& at = handles_->slots[slot].index;
+    if (at >= index) {
+      at += n;
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::handles_erase(
+  LNode& node,
+  const usize index,
+  const usize n
+) -> void {
+  if (not handles_) {
+    return;
+  }
+
+  const auto found = handles_->nodes.find(&node);
+  if (found == handles_->nodes.end()) {
+    return;
+  }
+
+  std::vector<u32>& slots = found->second;
+  for (usize k = 0; k < slots.size();) {
+    usize& at = handles_->slots[slots[k]].index;
+    if (at >= index and at < index + n) {
+      retire_handle(slots[k]);
+      slots[k] = slots.back();
+      slots.pop_back();
+      continue;
+    }
+
+    if (at >= index + n) {
+      at -= n;
+    }
+    k++;
+  }
+
+  if (slots.empty()) {
+    handles_->nodes.erase(found);
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::index_split(LNode& node, LNode& next) -> void {
+  if constexpr (Policy::Summary::enabled) {
+    summarize(node);
+    summarize(next);
+    directory_.fresh = false;
+  }
+
+  if (handles_) {
+    const auto found = handles_->nodes.find(&node);
+    if (found != handles_->nodes.end()) {
+      // the items from node.count on went to next
+      std::vector<u32>& slots = found->second;
+      std::vector<u32> moved;
+      for (usize k = 0; k < slots.size();) {
+        typename HandleTable::Slot& slot = handles_->slots[slots[k]];
+        if (slot.index >= node.count) {
+          slot.node = &next;
+          slot.index -= node.count;
+          moved.push_back(slots[k]);
+          slots[k] = slots.back();
+          slots.pop_back();
+          continue;
+        }
+        k++;
+      }
+
+      if (slots.empty()) {
+        handles_->nodes.erase(found);
+      }
+      if (not moved.empty()) {
+        handles_->nodes[&next] = std::move(moved);
+      }
+    }
+  }
+
+  if constexpr (LariatIsHashable<T>::value) {
+    if (not index_) {
+      return;
+    }
+
+    // anything first seen in the moved half now lives in next, unless the
+    // half that stayed behind holds another copy
+    for (usize j = 0; j < next.count; j++) {
+      const auto entry = index_->entries.find(next[j]);
+      if (entry != index_->entries.end() and entry->second.node == &node) {
+        entry->second.node = &next;
+      }
+    }
+
+    for (usize j = 0; j < node.count; j++) {
+      const auto entry = index_->entries.find(node[j]);
+      if (entry != index_->entries.end() and entry->second.node == &next) {
+        entry->second.node = &node;
+      }
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::summarize(LNode& node, const usize skip)
+  -> void {
+  node.summary = Policy::Summary::identity();
+  for (usize j = 0; j < node.count; j++) {
+    if (j != skip) {
+      Policy::Summary::add(node.summary, node[j]);
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::refresh_directory() const -> void {
+  if constexpr (Policy::Summary::enabled) {
+    if (directory_.fresh) {
+      return;
+    }
+
+    using Entry = typename SummaryDirectory::Entry;
+
+    usize leaves{1};
+    while (leaves < nodecount_) {
+      leaves *= 2;
+    }
+
+    auto& nodes = directory_.nodes;
+    auto& tree = directory_.tree;
+    nodes.assign(leaves, nullptr);
+    tree.assign(2 * leaves, Entry{0, Policy::Summary::identity()});
+    directory_.leaves = leaves;
+
+    usize rank{0};
+    for (LNode* node = head_; node; node = node->next, rank++) {
+      node->rank = rank;
+      nodes[rank] = node;
+      tree[leaves + rank] = {node->count, node->summary};
+    }
+
+    for (usize i = leaves - 1; i > 0; i--) {
+      tree[i] = {
+        tree[2 * i].items + tree[2 * i + 1].items,
+        Policy::Summary::combine(tree[2 * i].total, tree[2 * i + 1].total)
+      };
+    }
+
+    directory_.fresh = true;
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::seek_directory(const usize i) const noexcept
+  -> FindResult {
+  const auto& tree = directory_.tree;
+
+  usize index{i};
+  usize k{1};
+  while (k < directory_.leaves) {
+    const usize left = 2 * k;
+    if (index < tree[left].items) {
+      k = left;
+    } else {
+      index -= tree[left].items;
+      k = left + 1;
+    }
+  }
+
+  return {*directory_.nodes[k - directory_.leaves], index};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::update_directory(
+  const LNode& node,
+  const usize items
+) const -> void {
+  if constexpr (Policy::Summary::enabled) {
+    if (not directory_.fresh) {
+      return;
+    }
+
+    auto& tree = directory_.tree;
+    usize i = directory_.leaves + node.rank;
+    tree[i] = {items, node.summary};
+    for (i /= 2; i > 0; i /= 2) {
+      tree[i] = {
+        tree[2 * i].items + tree[2 * i + 1].items,
+        Policy::Summary::combine(tree[2 * i].total, tree[2 * i + 1].total)
+      };
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::live_slot(const LariatHandle handle)
+  const noexcept -> usize {
+  if (not handles_ or handle.slot >= handles_->slots.size()) {
+    return npos;
+  }
+
+  const typename HandleTable::Slot& slot = handles_->slots[handle.slot];
+  return slot.node and slot.generation == handle.generation ? handle.slot
+                                                            : npos;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::retire_handle(const u32 slot) -> void {
+  typename HandleTable::Slot& retired = handles_->slots[slot];
+  retired.node = nullptr;
+
+  // generation 0 would let a default handle match
+  if (++retired.generation == 0) {
+    retired.generation = 1;
+  }
+
+  retired.next_free = handles_->free_head;
+  handles_->free_head = slot;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::collect_handles() -> std::vector<PlacedHandle> {
+  std::vector<PlacedHandle> placed;
+  if (not handles_ or handles_->nodes.empty()) {
+    return placed;
+  }
+
+  const auto& slots = handles_->slots;
+  const auto by_index = [&slots](u32 lhs, u32 rhs) {
+    return slots[lhs].index < slots[rhs].index;
+  };
+
+  usize offset{0};
+  for (LNode* node = head_; node; node = node->next) {
+    const auto found = handles_->nodes.find(node);
+    if (found != handles_->nodes.end()) {
+      std::vector<u32>& here = found->second;
+      std::sort(here.begin(), here.end(), by_index);
+      for (const u32 slot: here) {
+        placed.push_back({offset + slots[slot].index, slot});
+      }
+    }
+    offset += node->count;
+  }
+  handles_->nodes.clear();
+
+  return placed;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::place_handles(
+  const std::vector<PlacedHandle>& placed
+) -> void {
+  LNode* node{head_};
+  usize offset{0};
+  for (const PlacedHandle& handle: placed) {
+    typename HandleTable::Slot& slot = handles_->slots[handle.slot];
+
+    // retired while the elements were moving
+    if (not slot.node) {
+      continue;
+    }
+
+    while (handle.global >= offset + node->count) {
+      offset += node->count;
+      node = node->next;
+    }
+
+    slot.node = node;
+    slot.index = handle.global - offset;
+    handles_->nodes[node].push_back(handle.slot);
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::index_offset(const LNode& node) const noexcept
+  -> usize {
+  if constexpr (LariatIsHashable<T>::value) {
+    if (node.offset < index_->clean_below) {
+      return node.offset;
+    }
+
+    usize offset = 0;
+    for (LNode* current = head_; current; current = current->next) {
+      current->offset = offset;
+      offset += current->count;
+    }
+    index_->clean_below = static_cast<usize>(-1);
+  }
+
+  return node.offset;
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::seek(Cursor& cursor, const usize i) const noexcept
+  -> FindResult {
+  // restart from an end when it is closer than the cursor
+  if (i < cursor.offset) {
+    if (i < cursor.offset - i) {
+      cursor = {head_, 0};
+    }
+  } else if (i - cursor.offset > size_ - i) {
+    cursor = {tail_, size_ - tail_->count};
+  }
+
+  usize hops{0};
+
+  while (i < cursor.offset) {
+    cursor.node = cursor.node->prev;
+    cursor.offset -= cursor.node->count;
+    hops++;
+  }
+
+  Lookahead ahead{cursor.node, (i - cursor.offset) / Size};
+  while (i >= cursor.offset + cursor.node->count) {
+    cursor.offset += cursor.node->count;
+    cursor.node = cursor.node->next;
+    ahead.step();
+    hops++;
+  }
+
+  stats_.on_lookup(hops);
+  return {*cursor.node, i - cursor.offset};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::unlink_empty() noexcept -> void {
+  LNode* node = head_;
+  while (node) {
+    LNode* const next = node->next;
+    if (node->count == 0) {
+      unlink(*node);
+    }
+    node = next;
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+Lariat<T, Size, Policy>::Lookahead::Lookahead(
+  const LNode* from,
+  const usize hops
+) noexcept:
+      node{hops > Policy::prefetch_distance ? from : nullptr} {
+  for (usize d = 0; d < Policy::prefetch_distance and node; d++) {
+    node = node->next;
+    if (node) {
+      // count sits before the items, the links after them
+      lariat_prefetch(node);
+      lariat_prefetch(&node->next);
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::Lookahead::step() noexcept -> void {
+  if constexpr (Policy::prefetch_distance > 0) {
+    if (node) {
+      node = node->next;
+    }
+    if (node) {
+      lariat_prefetch(node);
+      lariat_prefetch(&node->next);
+    }
+  }
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::find_element(const usize i) const noexcept
+  -> FindResult {
+  if constexpr (Policy::Summary::enabled) {
+    // the summary directory counts the items too, while it is up to date
+    if (directory_.fresh) {
+      stats_.on_lookup(0);
+      return seek_directory(i);
+    }
+  }
+
+  usize index{i};
+  usize hops{0};
+
+  LNode* node = head_;
+  Lookahead ahead{node, i / Size};
+  while (index >= node->count) {
+    index -= node->count;
+    node = node->next;
+    ahead.step();
+    hops++;
+  }
+
+  stats_.on_lookup(hops);
+  return {*node, index};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::begin() noexcept -> iterator {
+  return {this, head_, 0};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::end() noexcept -> iterator {
+  return {this, nullptr, 0};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::begin() const noexcept -> const_iterator {
+  return {this, head_, 0};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::end() const noexcept -> const_iterator {
+  return {this, nullptr, 0};
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::cbegin() const noexcept -> const_iterator {
+  return begin();
+}
+
+template<typename T, usize Size, typename Policy>
+auto Lariat<T, Size, Policy>::cend() const noexcept -> const_iterator {
+  return end();
+}
+
+template<typename T, usize Size, typename Policy, bool Const>
+auto LariatIterator<T, Size, Policy, Const>::operator++() noexcept
+  -> LariatIterator& {
+  if (++index_ == node_->count) {
+    node_ = node_->next;
+    index_ = 0;
+  }
+  return *this;
+}
+
+template<typename T, usize Size, typename Policy, bool Const>
+auto LariatIterator<T, Size, Policy, Const>::operator++(int) noexcept
+  -> LariatIterator {
+  LariatIterator before{*this};
+  ++*this;
+  return before;
+}
+
+template<typename T, usize Size, typename Policy, bool Const>
+auto LariatIterator<T, Size, Policy, Const>::operator--() noexcept
+  -> LariatIterator& {
+  if (not node_) {
+    node_ = list_->tail_;
+    index_ = node_->count;
+  } else if (index_ == 0) {
+    node_ = node_->prev;
+    index_ = node_->count;
+  }
+  index_--;
+  return *this;
+}
+
+template<typename T, usize Size, typename Policy, bool Const>
+auto LariatIterator<T, Size, Policy, Const>::operator--(int) noexcept
+  -> LariatIterator {
+  LariatIterator before{*this};
+  --*this;
+  return before;
+}
+
+template<typename T, usize Size, typename Policy, bool Const>
+auto LariatIterator<T, Size, Policy, Const>::segment() const noexcept
+  -> LariatSpan<std::remove_reference_t<reference>> {
+  if (not node_) {
+    return {};
+  }
+  return {&(*node_)[index_], node_->run_length(index_)};
+}
+
+template<typename It, typename Fn>
+auto LariatSegments::for_each_run(It first, const It& last, Fn&& fn) -> It {
+  while (first != last) {
+    usize n = first.node_->run_length(first.index_);
+    if (first.node_ == last.node_ and last.index_ > first.index_) {
+      n = std::min(n, last.index_ - first.index_);
+    }
+
+    const usize consumed = fn(&(*first.node_)[first.index_], n);
+    first.index_ += consumed;
+    if (consumed < n) {
+      break;
+    }
+
+    if (first.index_ == first.node_->count) {
+      first.node_ = first.node_->next;
+      first.index_ = 0;
+    }
+  }
+
+  return first;
+}
+
+template<typename It1, typename It2, typename Fn>
+auto LariatSegments::for_each_run_pair(It1 first1, It2 first2, Fn&& fn)
+  -> void {
+  while (first1.node_ and first2.node_) {
+    const usize n = std::min(
+      first1.node_->run_length(first1.index_),
+      first2.node_->run_length(first2.index_)
+    );
+
+    const usize consumed = fn(
+      &(*first1.node_)[first1.index_],
+      &(*first2.node_)[first2.index_],
+      n
+    );
+    if (consumed < n) {
+      return;
+    }
+
+    // each side hops to its next node once its own node is used up
+    first1.index_ += n;
+    if (first1.index_ == first1.node_->count) {
+      first1.node_ = first1.node_->next;
+      first1.index_ = 0;
+    }
+
+    first2.index_ += n;
+    if (first2.index_ == first2.node_->count) {
+      first2.node_ = first2.node_->next;
+      first2.index_ = 0;
+    }
+  }
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename OutputIt>
+auto copy(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  OutputIt out
+) -> OutputIt {
+  LariatSegments::for_each_run(first, last, [&out](const T* run, usize n) {
+    out = std::copy(run, run + n, out);
+    return n;
+  });
+  return out;
+}
+
+template<typename InputIt, typename T, usize Size, typename Policy>
+auto copy(
+  InputIt first,
+  InputIt last,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false> {
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+  if constexpr (std::is_base_of_v<std::random_access_iterator_tag, Category>) {
+    usize left = static_cast<usize>(last - first);
+    return LariatSegments::for_each_run(out, {}, [&](T* run, usize n) {
+      const usize k = std::min(n, left);
+      std::copy(first, first + static_cast<std::ptrdiff_t>(k), run);
+      first += static_cast<std::ptrdiff_t>(k);
+      left -= k;
+      return k;
+    });
+  } else {
+    return LariatSegments::for_each_run(out, {}, [&](T* run, usize n) {
+      usize k{0};
+      for (; k < n and first != last; k++, ++first) {
+        run[k] = *first;
+      }
+      return k;
+    });
+  }
+}
+
+template<
+  typename S,
+  usize OtherSize,
+  typename OtherPolicy,
+  bool Const,
+  typename T,
+  usize Size,
+  typename Policy>
+auto copy(
+  LariatIterator<S, OtherSize, OtherPolicy, Const> first,
+  LariatIterator<S, OtherSize, OtherPolicy, Const> last,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false> {
+  LariatSegments::for_each_run(first, last, [&out](const S* run, usize n) {
+    out = copy(run, run + n, out);
+    return n;
+  });
+  return out;
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename Count,
+  typename OutputIt>
+auto copy_n(
+  LariatIterator<T, Size, Policy, Const> first,
+  Count n,
+  OutputIt out
+) -> OutputIt {
+  usize left = n > 0 ? static_cast<usize>(n) : 0;
+  LariatSegments::for_each_run(first, {}, [&](const T* run, usize count) {
+    const usize k = std::min(count, left);
+    out = std::copy(run, run + k, out);
+    left -= k;
+    return k;
+  });
+  return out;
+}
+
+template<
+  typename InputIt,
+  typename Count,
+  typename T,
+  usize Size,
+  typename Policy>
+auto copy_n(
+  InputIt first,
+  Count n,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false> {
+  usize left = n > 0 ? static_cast<usize>(n) : 0;
+  return LariatSegments::for_each_run(out, {}, [&](T* run, usize count) {
+    const usize k = std::min(count, left);
+    first = std::copy_n(first, k, run);
+    left -= k;
+    return k;
+  });
+}
+
+template<
+  typename S,
+  usize OtherSize,
+  typename OtherPolicy,
+  bool Const,
+  typename Count,
+  typename T,
+  usize Size,
+  typename Policy>
+auto copy_n(
+  LariatIterator<S, OtherSize, OtherPolicy, Const> first,
+  Count n,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false> {
+  usize left = n > 0 ? static_cast<usize>(n) : 0;
+  LariatSegments::for_each_run(first, {}, [&](const S* run, usize count) {
+    const usize k = std::min(count, left);
+    out = copy(run, run + k, out);
+    left -= k;
+    return k;
+  });
+  return out;
+}
+
+template<typename T, usize Size, typename Policy, typename U>
+auto fill(
+  LariatIterator<T, Size, Policy, false> first,
+  LariatIterator<T, Size, Policy, false> last,
+  const U& value
+) -> void {
+  LariatSegments::for_each_run(first, last, [&value](T* run, usize n) {
+    std::fill(run, run + n, value);
+    return n;
+  });
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename InputIt>
+auto equal(
+  LariatIterator<T, Size, Policy, Const> first1,
+  LariatIterator<T, Size, Policy, Const> last1,
+  InputIt first2
+) -> bool {
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+  bool same{true};
+  LariatSegments::for_each_run(first1, last1, [&](const T* run, usize n) {
+    if constexpr (std::is_base_of_v<
+                    std::random_access_iterator_tag,
+                    Category>) {
+      if (not std::equal(run, run + n, first2)) {
+        same = false;
+        return usize{0};
+      }
+      first2 += static_cast<std::ptrdiff_t>(n);
+      return n;
+    }
+
+    for (usize k = 0; k < n; k++, ++first2) {
+      if (not(run[k] == *first2)) {
+        same = false;
+        return k;
+      }
+    }
+    return n;
+  });
+  return same;
+}
+
+template<typename T, usize Size, typename Policy, bool Const, typename U>
+auto find(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  const U& value
+) -> LariatIterator<T, Size, Policy, Const> {
+  return LariatSegments::for_each_run(first, last, [&](const T* run, usize n) {
+    return static_cast<usize>(std::find(run, run + n, value) - run);
+  });
+}
+
+template<typename T, usize Size, typename Policy, bool Const, typename Init>
+auto accumulate(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  Init init
+) -> Init {
+  LariatSegments::for_each_run(first, last, [&init](const T* run, usize n) {
+    for (usize k = 0; k < n; k++) {
+      init = std::move(init) + run[k];
+    }
+    return n;
+  });
+  return init;
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename Init,
+  typename BinaryOp>
+auto accumulate(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  Init init,
+  BinaryOp op
+) -> Init {
+  LariatSegments::for_each_run(first, last, [&](const T* run, usize n) {
+    for (usize k = 0; k < n; k++) {
+      init = op(std::move(init), run[k]);
+    }
+    return n;
+  });
+  return init;
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename InputIt>
+auto lexicographical_compare(
+  LariatIterator<T, Size, Policy, Const> first1,
+  LariatIterator<T, Size, Policy, Const> last1,
+  InputIt first2,
+  InputIt last2
+) -> bool {
+  // -1 once the first range orders before, 1 once it orders after
+  int order{0};
+  LariatSegments::for_each_run(first1, last1, [&](const T* run, usize n) {
+    for (usize k = 0; k < n; k++, ++first2) {
+      if (first2 == last2 or *first2 < run[k]) {
+        order = 1;
+        return k;
+      }
+      if (run[k] < *first2) {
+        order = -1;
+        return k;
+      }
+    }
+    return n;
+  });
+
+  return order == 0 ? first2 != last2 : order < 0;
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+auto operator==(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+
+  bool same{true};
+  LariatSegments::for_each_run_pair(
+    lhs.begin(),
+    rhs.begin(),
+    [&same](const T* a, const T* b, usize n) {
+      same = lariat_equal_run(a, b, n);
+      return same ? n : 0;
+    }
+  );
+  return same;
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+auto operator!=(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool {
+  return not(lhs == rhs);
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+auto operator<(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool {
+  // -1 once lhs orders before, 1 once it orders after
+  int order{0};
+  LariatSegments::for_each_run_pair(
+    lhs.begin(),
+    rhs.begin(),
+    [&order](const T* a, const T* b, usize n) {
+      // equal stretches, the common case, are skipped a whole run at a time
+      if (lariat_equal_run(a, b, n)) {
+        return n;
+      }
+
+      for (usize k = 0; k < n; k++) {
+        if (a[k] < b[k]) {
+          order = -1;
+          return k;
+        }
+        if (b[k] < a[k]) {
+          order = 1;
+          return k;
+        }
+      }
+      return n;
+    }
+  );
+
+  return order == 0 ? lhs.size() < rhs.size() : order < 0;
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+auto operator>(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool {
+  return rhs < lhs;
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+auto operator<=(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool {
+  return not(rhs < lhs);
+}
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+auto operator>=(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool {
+  return not(lhs < rhs);
+}
+
+template<typename T, usize Size, typename Policy>
+auto std::hash<Lariat<T, Size, Policy>>::operator()(
+  const Lariat<T, Size, Policy>& list
+) const -> usize {
+  constexpr u64 prime = 0x100000001b3;
+
+  u64 state{0xcbf29ce484222325};
+  list.for_each_chunk([&state](LariatSpan<const T> chunk) {
+    for (const T& value : chunk) {
+      // plain values are hashed by their bits, which skips a call per item
+      u64 bits{0};
+      if constexpr (std::has_unique_object_representations_v<T>
+                    and sizeof(T) <= sizeof(u64)) {
+        std::memcpy(&bits, &value, sizeof(T));
+      } else {
+        bits = static_cast<u64>(std::hash<T>{}(value));
+      }
+      state = (state ^ bits) * prime;
+    }
+  });
 
-  throw LariatException{LariatException::E_BAD_INDEX};
+  return static_cast<usize>((state ^ list.size()) * prime);
 }
 
 template<typename T>
-auto swap(T& lhs, T& rhs) -> void {
+auto swap(T& lhs, T& rhs) noexcept(
+  std::is_nothrow_move_constructible_v<T>
+  and std::is_nothrow_move_assignable_v<T>
+) -> void {
   T tmp = std::move(lhs);
   lhs = std::move(rhs);
   rhs = std::move(tmp);
@@ -4,10 +4,16 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <cstdint>
+#include <iosfwd>  // snapshots
 #include <string>  // error strings
 #include <utility> // error strings
 #include <cstring> // memcpy
-                   //
+#include <exception>
+#include <functional> // std::hash
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
 
 /**
  * @brief 32 Bit Floating Point Number
@@ -96,6 +102,7 @@ public:
       case E_NO_MEMORY: m_Description = "E_NO_MEMORY"; break;
       case E_BAD_INDEX: m_Description = "Subscript is out of range"; break;
       case E_DATA_ERROR: m_Description = "Data Error"; break;
+      case E_BAD_HANDLE: m_Description = "Handle is stale"; break;
       default: break;
     }
   }
@@ -109,215 +116,2037 @@ public:
   enum LARIAT_EXCEPTION {
     E_NO_MEMORY,
     E_BAD_INDEX,
-    E_DATA_ERROR
+    E_DATA_ERROR,
+    E_BAD_HANDLE
   };
 };
 
-// forward declaration for 1-1 operator<<
+/**
+ * @brief Whether std::hash can be used with the given type
+ */
+template<typename T, typename = void>
+struct LariatIsHashable : std::false_type {};
+
+template<typename T>
+struct LariatIsHashable<
+  T,
+  std::void_t<decltype(std::hash<T>{}(std::declval<const T&>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Enables the index overloads taking integer types other than usize,
+ * the index is converted to usize so a negative one ends up out of range
+ */
+template<typename Index>
+using LariatOtherIndex = std::enable_if_t<
+  std::is_integral_v<Index> and not std::is_same_v<Index, usize>
+  and not std::is_same_v<Index, bool>>;
+
+/**
+ * @brief Smallest unsigned type that can count the elements of a node holding
+ * up to Size values
+ */
+template<usize Size>
+using LariatCount = std::conditional_t<
+  (Size < 65536),
+  u16,
+  std::conditional_t<(Size <= 0xFFFFFFFFu), u32, usize>>;
+
+/**
+ * @brief Non owning view of a contiguous run of elements
+ */
+template<typename T>
+struct LariatSpan {
+  LariatSpan() noexcept = default;
+
+  LariatSpan(T* data, usize size) noexcept:
+      first{data}, count{size} {}
+
+  /**
+   * @brief span of T to span of const T
+   */
+  template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+  LariatSpan(const LariatSpan<U>& rhs) noexcept:
+      first{rhs.first}, count{rhs.count} {}
+
+  T* first{nullptr};
+  usize count{0};
+
+  [[nodiscard]] auto data() const -> T* { return first; }
+
+  [[nodiscard]] auto size() const -> usize { return count; }
+
+  [[nodiscard]] auto empty() const -> bool { return count == 0; }
+
+  [[nodiscard]] auto begin() const -> T* { return first; }
+
+  [[nodiscard]] auto end() const -> T* { return first + count; }
+
+  [[nodiscard]] auto operator[](usize i) const -> T& { return first[i]; }
+};
+
+/**
+ * @brief Hints the CPU to start loading the cache line at address
+ */
+inline auto lariat_prefetch(const void* address) noexcept -> void {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+/**
+ * @brief Converts from[0, n) into to[0, n) with static_cast
+ *
+ * Whole blocks have a fixed trip count, which the optimizer turns into
+ * vector conversions for arithmetic types even at -O2.
+ */
+template<typename S, typename T>
+inline auto lariat_convert(const S* from, usize n, T* to) -> void {
+  constexpr usize block = 16;
+
+  usize i{0};
+  for (; i + block <= n; i += block) {
+    for (usize j = 0; j < block; j++) {
+      to[i + j] = static_cast<T>(from[i + j]);
+    }
+  }
+
+  for (; i < n; i++) {
+    to[i] = static_cast<T>(from[i]);
+  }
+}
+
+/**
+ * @brief Whether a[0, n) and b[0, n) hold equal items
+ *
+ * Types whose value is exactly their bytes are compared with memcmp, which
+ * the library does with wide vector loads.
+ */
+template<typename T>
+inline auto lariat_equal_run(const T* a, const T* b, usize n) -> bool {
+  if constexpr (std::has_unique_object_representations_v<T>) {
+    return n == 0 or std::memcmp(a, b, n * sizeof(T)) == 0;
+  } else {
+    for (usize i = 0; i < n; i++) {
+      if (not(a[i] == b[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+/**
+ * @brief Number of set bits
+ */
+inline auto lariat_popcount(u64 bits) noexcept -> usize {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<usize>(__builtin_popcountll(bits));
+#else
+  usize n{0};
+  for (; bits; bits &= bits - 1) {
+    n++;
+  }
+  return n;
+#endif
+}
+
+/**
+ * @brief Position of the n-th (from 0) set bit, which must exist
+ */
+inline auto lariat_select_bit(u64 bits, usize n) noexcept -> usize {
+  for (; n > 0; n--) {
+    bits &= bits - 1;
+  }
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<usize>(__builtin_ctzll(bits));
+#else
+  usize position{0};
+  for (; not(bits & 1); bits >>= 1) {
+    position++;
+  }
+  return position;
+#endif
+}
+
+/**
+ * @brief Operations understood by Lariat::apply_batch
+ */
+enum class LariatOp : u8 {
+  insert,
+  erase,
+  push_back,
+  push_front,
+  pop_back,
+  pop_front,
+  compact,
+  read,
+  find
+};
+
+/**
+ * @brief One operation of a batch, see Lariat::apply_batch
+ */
+template<typename T>
+struct LariatBatchOp {
+  LariatOp op;
+
+  // index for insert, erase and read, receives the result of find
+  usize position;
+
+  // value for insert, the pushes and find, receives the result of read
+  T value;
+};
+
+/**
+ * @brief Stable reference to one element of a Lariat, see Lariat::handle
+ *
+ * A default constructed handle refers to nothing.
+ */
+struct LariatHandle {
+  u32 slot{0};
+
+  // the slot is reused once the element is erased, a stale handle no longer
+  // matches its generation
+  u32 generation{0};
+};
+
+inline auto operator==(const LariatHandle& lhs, const LariatHandle& rhs)
+  noexcept -> bool {
+  return lhs.slot == rhs.slot and lhs.generation == rhs.generation;
+}
+
+inline auto operator!=(const LariatHandle& lhs, const LariatHandle& rhs)
+  noexcept -> bool {
+  return not (lhs == rhs);
+}
+
+/**
+ * @brief Element storage of a node: a window [start, start + count) sliding
+ * inside a fixed array
+ *
+ * Insert and erase move whichever side of the index is shorter, so pushes and
+ * pops at either end of a node are O(1) while the window has room on that
+ * side. When the shorter side hits the end of the array the window is moved
+ * back to the middle first. The elements always stay contiguous.
+ */
 template<typename T, usize Size>
-class Lariat;
+struct LariatWindowStorage {
+  // counts and slot positions, sized to Size
+  using Count = LariatCount<Size>;
+
+  // number of items currently in the node
+  Count count = 0;
+
+  // slot of the first item
+  Count start = 0;
+
+  T slots[Size];
+
+  [[nodiscard]] auto operator[](usize i) noexcept -> T& {
+    return slots[start + i];
+  }
+
+  [[nodiscard]] auto operator[](usize i) const noexcept -> const T& {
+    return slots[start + i];
+  }
+
+  /**
+   * @brief Number of items from index on that sit in consecutive slots
+   */
+  [[nodiscard]] auto run_length(usize index) const noexcept -> usize {
+    return count - index;
+  }
+
+  /**
+   * @brief Inserts value before index, the node must not be full
+   *
+   * @return Number of elements moved
+   */
+  auto insert(usize index, const T& value) noexcept(
+    std::is_nothrow_move_assignable_v<T>
+    and std::is_nothrow_copy_assignable_v<T>
+  ) -> usize;
+
+  /**
+   * @brief Removes the item at index
+   *
+   * @return Number of elements moved
+   */
+  auto erase(usize index) noexcept(std::is_nothrow_move_assignable_v<T>)
+    -> usize;
+
+  /**
+   * @brief Moves items [from, count) to the front of an empty storage
+   */
+  auto split_to(usize from, LariatWindowStorage& dest) noexcept(
+    std::is_nothrow_move_assignable_v<T>
+  ) -> void;
+
+  /**
+   * @brief Moves the window so that it begins at the given slot
+   *
+   * @return Number of elements moved
+   */
+  auto slide(usize new_start) noexcept(std::is_nothrow_move_assignable_v<T>)
+    -> usize;
+
+  /**
+   * @brief Declares slots [0, n) to hold the items, used to fill a node in
+   * place after slide(0) or when it is empty
+   *
+   * @return The first slot
+   */
+  auto set_front(usize n) noexcept -> T*;
+
+  /**
+   * @brief Drops lazily erased slots, there are none in this layout
+   */
+  auto purge() noexcept -> usize { return 0; }
+
+  /**
+   * @brief Calls fn(pointer, count) for every contiguous run of items, in
+   * order
+   */
+  template<typename Fn>
+  auto for_each_segment(Fn&& fn) const -> void;
+};
+
+/**
+ * @brief Element storage of a node that keeps its free slots as a gap at the
+ * last edit position: items [0, gap) then a gap of Size - count slots, then
+ * the remaining items
+ *
+ * An insert or erase first moves the gap to its index, so a run of edits at
+ * (or next to) the same position moves nothing after the first one. Any
+ * other index costs the distance the gap travels.
+ */
+template<typename T, usize Size>
+struct LariatGapStorage {
+  // counts and slot positions, sized to Size
+  using Count = LariatCount<Size>;
+
+  // number of items currently in the node
+  Count count = 0;
+
+  // slot of the first free slot (and the number of items before the gap)
+  Count gap = 0;
+
+  T slots[Size];
+
+  [[nodiscard]] auto operator[](usize i) noexcept -> T& {
+    return slots[i < gap ? i : i + (Size - count)];
+  }
+
+  [[nodiscard]] auto operator[](usize i) const noexcept -> const T& {
+    return slots[i < gap ? i : i + (Size - count)];
+  }
+
+  /**
+   * @brief Number of items from index on that sit in consecutive slots
+   */
+  [[nodiscard]] auto run_length(usize index) const noexcept -> usize {
+    return index < gap ? gap - index : count - index;
+  }
+
+  /**
+   * @brief Inserts value before index, the node must not be full
+   *
+   * @return Number of elements moved
+   */
+  auto insert(usize index, const T& value) noexcept(
+    std::is_nothrow_move_assignable_v<T>
+    and std::is_nothrow_copy_assignable_v<T>
+  ) -> usize;
+
+  /**
+   * @brief Removes the item at index
+   *
+   * @return Number of elements moved
+   */
+  auto erase(usize index) noexcept(std::is_nothrow_move_assignable_v<T>)
+    -> usize;
+
+  /**
+   * @brief Moves items [from, count) to the front of an empty storage
+   */
+  auto split_to(usize from, LariatGapStorage& dest) noexcept(
+    std::is_nothrow_move_assignable_v<T>
+  ) -> void;
+
+  /**
+   * @brief Packs the items at the front (0) or back (Size - count) of the
+   * array, moving the gap to the other end
+   *
+   * @return Number of elements moved
+   */
+  auto slide(usize new_start) noexcept(std::is_nothrow_move_assignable_v<T>)
+    -> usize;
+
+  /**
+   * @brief Declares slots [0, n) to hold the items, used to fill a node in
+   * place after slide(0) or when it is empty
+   *
+   * @return The first slot
+   */
+  auto set_front(usize n) noexcept -> T*;
+
+  /**
+   * @brief Drops lazily erased slots, there are none in this layout
+   */
+  auto purge() noexcept -> usize { return 0; }
+
+  /**
+   * @brief Calls fn(pointer, count) for every contiguous run of items, in
+   * order
+   */
+  template<typename Fn>
+  auto for_each_segment(Fn&& fn) const -> void;
+
+private:
+
+  /**
+   * @brief Moves the gap so that it starts before the item at index
+   */
+  auto move_gap(usize index) noexcept(std::is_nothrow_move_assignable_v<T>)
+    -> usize;
+};
+
+/**
+ * @brief Element storage of a node with lazy erase: items sit in slots
+ * [0, used) and a bit per slot tells whether it is still live
+ *
+ * Erase only clears the bit. Indexing skips dead slots by counting bits a
+ * word at a time. The slots are packed again (purged) when more than
+ * DeadPercent of the node is dead, when an insert needs the room, and by
+ * Lariat::compact. Inserting right after a dead slot reuses it.
+ */
+template<typename T, usize Size, usize DeadPercent = 50>
+struct LariatTombstoneStorage {
+  static constexpr usize words = (Size + 63) / 64;
+
+  // counts and slot positions, sized to Size
+  using Count = LariatCount<Size>;
+
+  // number of live items
+  Count count = 0;
+
+  // slots holding live or dead items
+  Count used = 0;
+
+  u64 live[words]{};
+
+  T slots[Size];
+
+  [[nodiscard]] auto operator[](usize i) noexcept -> T& {
+    return slots[slot_of(i)];
+  }
+
+  [[nodiscard]] auto operator[](usize i) const noexcept -> const T& {
+    return slots[slot_of(i)];
+  }
+
+  /**
+   * @brief Number of items from index on that sit in consecutive slots
+   */
+  [[nodiscard]] auto run_length(usize index) const noexcept -> usize;
+
+  /**
+   * @brief Inserts value before index, the node must not be full
+   *
+   * @return Number of elements moved
+   */
+  auto insert(usize index, const T& value) noexcept(
+    std::is_nothrow_move_assignable_v<T>
+    and std::is_nothrow_copy_assignable_v<T>
+  ) -> usize;
+
+  /**
+   * @brief Marks the item at index dead
+   *
+   * @return Number of elements moved (by a purge)
+   */
+  auto erase(usize index) noexcept(std::is_nothrow_move_assignable_v<T>)
+    -> usize;
+
+  /**
+   * @brief Moves items [from, count) to the front of an empty storage
+   */
+  auto split_to(usize from, LariatTombstoneStorage& dest) noexcept(
+    std::is_nothrow_move_assignable_v<T>
+  ) -> void;
+
+  /**
+   * @brief Packs the items at the front of the array (the requested start is
+   * only a hint for this layout)
+   *
+   * @return Number of elements moved
+   */
+  auto slide(usize new_start) noexcept(std::is_nothrow_move_assignable_v<T>)
+    -> usize;
+
+  /**
+   * @brief Declares slots [0, n) to hold the items, used to fill a node in
+   * place after slide(0) or when it is empty
+   *
+   * @return The first slot
+   */
+  auto set_front(usize n) noexcept -> T*;
+
+  /**
+   * @brief Packs the live items at the front, dropping the dead slots
+   *
+   * @return Number of elements moved
+   */
+  auto purge() noexcept(std::is_nothrow_move_assignable_v<T>) -> usize;
+
+  /**
+   * @brief Calls fn(pointer, count) for every contiguous run of items, in
+   * order
+   */
+  template<typename Fn>
+  auto for_each_segment(Fn&& fn) const -> void;
+
+private:
+
+  [[nodiscard]] auto is_live(usize slot) const noexcept -> bool {
+    return live[slot / 64] >> (slot % 64) & 1;
+  }
+
+  /**
+   * @brief Slot of the item at index
+   */
+  [[nodiscard]] auto slot_of(usize index) const noexcept -> usize;
+
+  /**
+   * @brief Marks slots [0, n) live and the rest dead
+   */
+  auto mark_front(usize n) noexcept -> void;
+};
+
+/**
+ * @brief Fixed layout header that starts every binary Lariat snapshot, values
+ * are stored in native byte order
+ */
+struct LariatSnapshotHeader {
+  char magic[4];
+
+  u32 version;
+
+  // LariatSerializer<T>::tag of the element type
+  u32 type_tag;
+
+  // sizeof(T) of the element type
+  u32 value_size;
+
+  // node capacity of the Lariat that wrote the snapshot
+  u64 node_size;
+
+  // number of elements
+  u64 size;
+
+  // number of node blocks following the header
+  u64 node_count;
+};
+
+/**
+ * @brief Customisation point for reading and writing Lariat elements in
+ * snapshots, the default works for any trivially copyable T and moves whole
+ * arrays with a single read/write call
+ *
+ * A specialisation must provide a u32 tag identifying the on-disk format and
+ * write/read functions with the signatures below
+ */
+template<typename T, typename = void>
+struct LariatSerializer {
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "Specialise LariatSerializer<T> to snapshot non trivially copyable types"
+  );
+
+  static constexpr u32 tag = std::is_arithmetic_v<T>
+                             ? (std::is_floating_point_v<T> ? u32{'f'}
+                                : std::is_signed_v<T>       ? u32{'i'}
+                                                            : u32{'u'})
+                                     << 8
+                                 | static_cast<u32>(sizeof(T))
+                             : 0;
+
+  static auto write(std::ostream& os, const T* values, usize count) -> void;
+
+  static auto read(std::istream& is, T* values, usize count) -> void;
+};
+
+/**
+ * @brief Index checking policy that throws LariatException E_BAD_INDEX
+ */
+struct LariatThrowChecks {
+  static constexpr bool nothrow = false;
+
+  static auto check(bool valid) -> void;
+};
+
+/**
+ * @brief Index checking policy that only asserts, compiled out with NDEBUG
+ */
+struct LariatAssertChecks {
+  static constexpr bool nothrow = true;
+
+  static auto check(bool valid) noexcept -> void;
+};
+
+/**
+ * @brief Index checking policy that trusts every index, out of range access
+ * is undefined behaviour
+ */
+struct LariatNoChecks {
+  static constexpr bool nothrow = true;
+
+  static auto check(bool) noexcept -> void {}
+};
+
+/**
+ * @brief Stats policy that records nothing, every hook compiles away
+ */
+struct LariatNoStats {
+  static constexpr bool enabled = false;
+
+  auto on_split() noexcept -> void {}
+
+  auto on_shift(usize) noexcept -> void {}
+
+  auto on_lookup(usize) noexcept -> void {}
+
+  auto on_allocate() noexcept -> void {}
+
+  auto on_free() noexcept -> void {}
+
+  auto on_compact() noexcept -> void {}
+};
+
+/**
+ * @brief Stats policy that counts the internal events of a Lariat
+ */
+struct LariatCountingStats {
+  static constexpr bool enabled = true;
+
+  // nodes split in two by insert/push_front
+  u64 splits{0};
+
+  // elements moved inside nodes by inserts and erases
+  u64 shifted_elements{0};
+
+  // find_element calls
+  u64 lookups{0};
+
+  // nodes stepped over by find_element
+  u64 node_hops{0};
+
+  // make_node calls
+  u64 allocations{0};
+
+  // nodes destroyed
+  u64 frees{0};
+
+  // compact calls that moved elements, automatic ones included
+  u64 compactions{0};
+
+  auto on_split() noexcept -> void { splits++; }
+
+  auto on_shift(usize moved) noexcept -> void { shifted_elements += moved; }
+
+  auto on_lookup(usize hops) noexcept -> void {
+    lookups++;
+    node_hops += hops;
+  }
+
+  auto on_allocate() noexcept -> void { allocations++; }
+
+  auto on_free() noexcept -> void { frees++; }
+
+  auto on_compact() noexcept -> void { compactions++; }
+};
+
+/**
+ * @brief Occupancy policy that leaves compacting to the caller
+ */
+struct LariatManualCompact {
+  static constexpr bool automatic = false;
+  static constexpr usize low_percent = 0;
+  static constexpr usize high_percent = 0;
+};
+
+/**
+ * @brief Occupancy policy that compacts once the fill factor (elements over
+ * node capacity) drops below Low percent, and only again after it has been
+ * back above High percent
+ *
+ * The band between the marks bounds the overhead to 100 / Low times the
+ * ideal node count and keeps a list hovering around Low from compacting on
+ * every operation: each compaction is paid for by the splits and erases that
+ * took the fill factor from High down to Low.
+ */
+template<usize Low = 50, usize High = 75>
+struct LariatWaterMarks {
+  static_assert(Low < High and High <= 100, "Need Low < High <= 100");
+
+  static constexpr bool automatic = true;
+  static constexpr usize low_percent = Low;
+  static constexpr usize high_percent = High;
+};
+
+/**
+ * @brief Node summary policy that keeps nothing, see Lariat::seek_summary
+ *
+ * A summary policy provides a Value with its identity(), add to account for
+ * one item entering a node and combine to total the Values of consecutive
+ * nodes. When invertible, remove takes one item back out; otherwise a node
+ * losing an item is summarized again from the items that stay.
+ */
+struct LariatNoSummary {
+  static constexpr bool enabled = false;
+  static constexpr bool invertible = true;
+
+  struct Value {};
+
+  static auto identity() noexcept -> Value { return {}; }
+
+  template<typename T>
+  static auto add(Value&, const T&) noexcept -> void {}
+
+  template<typename T>
+  static auto remove(Value&, const T&) noexcept -> void {}
+
+  static auto combine(Value, const Value&) noexcept -> Value { return {}; }
+};
+
+/**
+ * @brief Node summary for text held as UTF-8 chars: the newlines and code
+ * points (every byte that is not a continuation byte) of each node
+ */
+struct LariatTextSummary {
+  static constexpr bool enabled = true;
+  static constexpr bool invertible = true;
+
+  struct Value {
+    usize lines{0};
+    usize codepoints{0};
+  };
+
+  static auto identity() noexcept -> Value { return {}; }
+
+  static auto add(Value& value, const char c) noexcept -> void {
+    value.lines += c == '\n' ? 1 : 0;
+    value.codepoints += (static_cast<u8>(c) & 0xC0) != 0x80 ? 1 : 0;
+  }
+
+  static auto remove(Value& value, const char c) noexcept -> void {
+    value.lines -= c == '\n' ? 1 : 0;
+    value.codepoints -= (static_cast<u8>(c) & 0xC0) != 0x80 ? 1 : 0;
+  }
+
+  static auto combine(Value lhs, const Value& rhs) noexcept -> Value {
+    lhs.lines += rhs.lines;
+    lhs.codepoints += rhs.codepoints;
+    return lhs;
+  }
+};
+
+/**
+ * @brief Sum monoid for LariatAggregate
+ */
+template<typename T>
+struct LariatSum {
+  using Value = T;
+
+  static constexpr bool invertible = true;
+
+  static auto identity() -> Value { return Value{}; }
+
+  static auto combine(Value lhs, const Value& rhs) -> Value {
+    return lhs + rhs;
+  }
+
+  // lhs without rhs
+  static auto invert(Value lhs, const Value& rhs) -> Value {
+    return lhs - rhs;
+  }
+};
+
+/**
+ * @brief Minimum monoid for LariatAggregate
+ */
+template<typename T>
+struct LariatMin {
+  using Value = T;
+
+  static constexpr bool invertible = false;
+
+  static auto identity() -> Value { return std::numeric_limits<T>::max(); }
+
+  static auto combine(const Value& lhs, const Value& rhs) -> Value {
+    return rhs < lhs ? rhs : lhs;
+  }
+};
+
+/**
+ * @brief Maximum monoid for LariatAggregate
+ */
+template<typename T>
+struct LariatMax {
+  using Value = T;
+
+  static constexpr bool invertible = false;
+
+  static auto identity() -> Value { return std::numeric_limits<T>::lowest(); }
+
+  static auto combine(const Value& lhs, const Value& rhs) -> Value {
+    return lhs < rhs ? rhs : lhs;
+  }
+};
+
+/**
+ * @brief Node summary holding the Monoid total of the node's items, see
+ * Lariat::range_query
+ *
+ * Monoid provides a Value built from an item, identity(), an associative
+ * combine and, when invertible, invert(total, item) taking an item back out
+ * (see LariatSum, LariatMin and LariatMax).
+ */
+template<typename Monoid>
+struct LariatAggregate {
+  using Value = typename Monoid::Value;
+
+  static constexpr bool enabled = true;
+  static constexpr bool invertible = Monoid::invertible;
+
+  static auto identity() -> Value { return Monoid::identity(); }
+
+  template<typename T>
+  static auto add(Value& total, const T& item) -> void {
+    total = Monoid::combine(std::move(total), static_cast<Value>(item));
+  }
+
+  template<typename T>
+  static auto remove(Value& total, const T& item) -> void {
+    if constexpr (invertible) {
+      total = Monoid::invert(std::move(total), static_cast<Value>(item));
+    }
+  }
+
+  static auto combine(Value lhs, const Value& rhs) -> Value {
+    return Monoid::combine(std::move(lhs), rhs);
+  }
+};
+
+/**
+ * @brief Snapshot of a Lariat's counters and node occupancy, see
+ * Lariat::stats
+ */
+struct LariatStatsReport {
+  // number of buckets in fill_histogram
+  static constexpr usize fill_buckets = 10;
+
+  // false if the Lariat was built with LariatNoStats, counters are then 0
+  bool counting{false};
+
+  LariatCountingStats counters{};
+
+  // number of elements
+  usize size{0};
+
+  // node capacity (the Size parameter)
+  usize node_size{0};
+
+  // nodes currently allocated
+  usize nodes{0};
+
+  // nodes a fully compacted list would need
+  usize ideal_nodes{0};
+
+  // nodes holding no element
+  usize empty_nodes{0};
+
+  // node count per fill factor decile, full nodes land in the last bucket
+  usize fill_histogram[fill_buckets]{};
+
+  // heap and object bytes divided by the number of elements
+  double bytes_per_element{0};
+
+  /**
+   * @brief Writes the report as a single JSON object
+   */
+  auto write_json(std::ostream& os) const -> void;
+};
+
+/**
+ * @brief Compile time configuration of a Lariat, derive from it and override
+ * individual members to change a policy
+ */
+struct LariatDefaultPolicy {
+  /**
+   * @brief Operation counters, LariatNoStats or LariatCountingStats
+   */
+  using Stats = LariatNoStats;
+
+  /**
+   * @brief What an out of range index does, LariatThrowChecks,
+   * LariatAssertChecks or LariatNoChecks (at() always throws)
+   */
+  using Checks = LariatThrowChecks;
+
+  /**
+   * @brief Element storage of a node, LariatWindowStorage, LariatGapStorage
+   * or LariatTombstoneStorage (any type with the same members works)
+   */
+  template<typename T, usize Size>
+  using Storage = LariatWindowStorage<T, Size>;
+
+  /**
+   * @brief Embed one node in the Lariat object itself, lists that fit in a
+   * single node then never touch the allocator
+   */
+  static constexpr bool inline_node = false;
+
+  /**
+   * @brief When to compact without being asked, LariatManualCompact or
+   * LariatWaterMarks
+   */
+  using Occupancy = LariatManualCompact;
+
+  /**
+   * @brief Threads converting the items of another instantiation (1 keeps
+   * it on the calling thread), used for arithmetic types only
+   */
+  static constexpr usize convert_threads = 1;
+
+  /**
+   * @brief Smallest list converted on several threads
+   */
+  static constexpr usize convert_parallel_min = usize{1} << 20;
+
+  /**
+   * @brief How many nodes ahead a forward walk starts loading, 0 turns
+   * software prefetching off
+   */
+  static constexpr usize prefetch_distance = 2;
+
+  /**
+   * @brief What each node caches about its items, LariatNoSummary or e.g.
+   * LariatTextSummary, see Lariat::seek_summary
+   */
+  using Summary = LariatNoSummary;
+};
+
+/**
+ * @brief Default policy with operation counters turned on
+ */
+struct LariatStatsPolicy : LariatDefaultPolicy {
+  using Stats = LariatCountingStats;
+};
+
+/**
+ * @brief Default policy with gap buffer nodes, for workloads that insert or
+ * erase many elements at a slowly moving cursor
+ */
+struct LariatGapPolicy : LariatDefaultPolicy {
+  template<typename T, usize Size>
+  using Storage = LariatGapStorage<T, Size>;
+};
+
+/**
+ * @brief Default policy that compacts below half full nodes, for long
+ * running lists with churn
+ */
+struct LariatAutoCompactPolicy : LariatDefaultPolicy {
+  using Occupancy = LariatWaterMarks<>;
+};
+
+/**
+ * @brief Default policy with lazily erasing nodes, for erase heavy phases
+ */
+struct LariatTombstonePolicy : LariatDefaultPolicy {
+  template<typename T, usize Size>
+  using Storage = LariatTombstoneStorage<T, Size>;
+};
+
+/**
+ * @brief Default policy with the first node stored inline, for many short
+ * lists
+ */
+struct LariatInlinePolicy : LariatDefaultPolicy {
+  static constexpr bool inline_node = true;
+};
+
+/**
+ * @brief Gap buffer policy with newline and code point counts per node, for
+ * Lariat<char> text buffers, see LariatText
+ */
+struct LariatTextPolicy : LariatGapPolicy {
+  using Summary = LariatTextSummary;
+};
+
+/**
+ * @brief Default policy keeping a Monoid total per node, for range_query
+ */
+template<typename Monoid>
+struct LariatAggregatePolicy : LariatDefaultPolicy {
+  using Summary = LariatAggregate<Monoid>;
+};
+
+/**
+ * @brief Default policy without index checks, for hot loops whose indices are
+ * known to be valid
+ */
+struct LariatUncheckedPolicy : LariatDefaultPolicy {
+  using Checks = LariatNoChecks;
+};
+
+// forward declaration for 1-1 operator<<
+template<typename T, usize Size, typename Policy = LariatDefaultPolicy>
+class Lariat;
+
+template<typename T, usize Size, typename Policy>
+std::ostream& operator<<(std::ostream& os, const Lariat<T, Size, Policy>& rhs);
+
+template<typename T, usize Size, typename Policy, bool Const>
+class LariatIterator;
+
+struct LariatSegments;
+
+/**
+ * @brief Rope Data structure
+ */
+template<typename T, usize Size, typename Policy>
+class Lariat {
+public:
+
+  template<typename S, usize OtherSize, typename OtherPolicy>
+  friend class Lariat;
+
+  template<typename S, usize OtherSize, typename OtherPolicy, bool Const>
+  friend class LariatIterator;
+
+  friend struct LariatSegments;
+
+  using iterator = LariatIterator<T, Size, Policy, false>;
+  using const_iterator = LariatIterator<T, Size, Policy, true>;
+
+private:
+
+  struct LNode;
+
+public:
+
+  /**
+   * @brief Default constructor
+   */
+  Lariat() noexcept;
+
+  /**
+   * @brief Copy constructor
+   */
+  Lariat(const Lariat& rhs);
+
+  /**
+   * @brief Copy constructor from another lariat type
+   *
+   * @tparam S Other type that can be casted to T
+   * @param rhs other instance of a lariat type
+   */
+  template<typename S, usize OtherSize, typename OtherPolicy>
+  Lariat(const Lariat<S, OtherSize, OtherPolicy>& rhs);
+
+  /**
+   * @brief Move constructor, takes the nodes of rhs and leaves it empty
+   */
+  Lariat(Lariat&& rhs) noexcept(not Policy::inline_node);
+
+  /**
+   * @brief Destructor
+   */
+  ~Lariat();
+
+  /**
+   * @brief Copy assignment
+   */
+  auto operator=(const Lariat& rhs) -> Lariat&;
+
+  /**
+   * @brief Copy assignment
+   */
+  template<typename S, usize OtherSize, typename OtherPolicy>
+  auto operator=(const Lariat<S, OtherSize, OtherPolicy>& rhs) -> Lariat&;
+
+  /**
+   * @brief Move assignment, takes the nodes of rhs and leaves it empty
+   */
+  auto operator=(Lariat&& rhs) -> Lariat&;
+
+  /**
+   * @brief Insert a value into the given index
+   *
+   * @param index Position of the new value, at most size()
+   * @param value Value to insert
+   */
+  auto insert(usize index, const T& value) -> void;
+
+  /**
+   * @brief Insert a value into the given index, for int (the original
+   * interface) and every other integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  auto insert(Index index, const T& value) -> void;
+
+  /**
+   * @brief Inserts values in front of the item at index, a node at a time
+   *
+   * What fits into the node at index is moved in with one shift. Otherwise
+   * the items behind index move to a node of their own and the values fill
+   * the node and whole new nodes in between. Summaries and handles are
+   * updated once per node touched, with a value index the values go in one
+   * by one.
+   *
+   * @throws as Policy::Checks unless index <= size()
+   */
+  auto insert(usize index, LariatSpan<const T> values) -> void;
+
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  auto insert(Index index, LariatSpan<const T> values) -> void {
+    insert(static_cast<usize>(index), values);
+  }
+
+  /**
+   * @brief Pushes a value to the end of the list
+   */
+  auto push_back(const T& value) -> void;
+
+  /**
+   * @brief Pushes a value to the beginning of the list
+   */
+  auto push_front(const T& value) -> void;
+
+  /**
+   * @brief Erases value at the given index
+   */
+  auto erase(usize index) -> void;
+
+  /**
+   * @brief Erases value at the given index, for int (the original interface)
+   * and every other integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  auto erase(Index index) -> void;
+
+  /**
+   * @brief Erases the items [first, last), a node at a time
+   *
+   * Nodes inside the range are dropped whole, the nodes at either end are
+   * closed up with one shift each. With a value index the items go one by
+   * one.
+   *
+   * @throws as Policy::Checks unless first <= last <= size()
+   */
+  auto erase(usize first, usize last) -> void;
+
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  auto erase(Index first, Index last) -> void {
+    erase(static_cast<usize>(first), static_cast<usize>(last));
+  }
+
+  /**
+   * @brief Removes a value from the end of the list
+   */
+  auto pop_back() -> void;
+
+  /**
+   * @brief Removes a value from the beginning of the list
+   */
+  auto pop_front() -> void;
+
+  /**
+   * @brief Gives the value at the given index, checked by Policy::Checks
+   */
+  [[nodiscard]] auto operator[](usize index) noexcept(Policy::Checks::nothrow)
+    -> T&;
+
+  /**
+   * @brief Gives the value at the given index, checked by Policy::Checks
+   */
+  [[nodiscard]] auto operator[](usize index) const
+    noexcept(Policy::Checks::nothrow) -> const T&;
+
+  /**
+   * @brief operator[] for int (the original interface) and every other
+   * integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto operator[](Index index) noexcept(Policy::Checks::nothrow)
+    -> T&;
+
+  /**
+   * @brief operator[] for int (the original interface) and every other
+   * integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto operator[](Index index) const
+    noexcept(Policy::Checks::nothrow) -> const T&;
+
+  /**
+   * @brief Gives the value at the given index, always throws
+   * LariatException E_BAD_INDEX when out of range whatever the policy
+   */
+  [[nodiscard]] auto at(usize index) -> T&;
+
+  /**
+   * @brief Gives the value at the given index, always throws
+   * LariatException E_BAD_INDEX when out of range whatever the policy
+   */
+  [[nodiscard]] auto at(usize index) const -> const T&;
+
+  /**
+   * @brief at() for int and every other integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto at(Index index) -> T&;
+
+  /**
+   * @brief at() for int and every other integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto at(Index index) const -> const T&;
+
+  /**
+   * @brief Gets the first element of the list, checked by Policy::Checks
+   */
+  [[nodiscard]] auto first() noexcept(Policy::Checks::nothrow) -> T&;
+
+  /**
+   * @brief Gets the first element of the list, checked by Policy::Checks
+   */
+  [[nodiscard]] auto first() const noexcept(Policy::Checks::nothrow)
+    -> const T&;
+
+  /**
+   * @brief Gets the last element of the list, checked by Policy::Checks
+   */
+  [[nodiscard]] auto last() noexcept(Policy::Checks::nothrow) -> T&;
+
+  /**
+   * @brief Gets the last element of the list, checked by Policy::Checks
+   */
+  [[nodiscard]] auto last() const noexcept(Policy::Checks::nothrow)
+    -> const T&;
+
+  /**
+   * @brief index_of returns this when the value is missing
+   */
+  static constexpr usize npos = static_cast<usize>(-1);
+
+  // returns index, size (one past last) if not found
+  [[nodiscard]] auto find(const T& value) const -> u32;
+
+  /**
+   * @brief Index of the first occurrence of value, or npos, find for lists
+   * past the u32 range
+   */
+  [[nodiscard]] auto index_of(const T& value) const -> usize;
+
+  /**
+   * @brief Builds a value -> node index so that find runs in O(1) expected
+   * time, the index is then kept up to date by every mutation
+   *
+   * Upkeep is O(1) expected per insert or erase of a distinct value. A value
+   * stored more than once costs more when its first occurrence changes:
+   * erasing the first copy walks the nodes up to the next copy, and inserting
+   * a copy ahead of a first copy whose offset went stale recounts the node
+   * offsets, both O(size() / Size) at worst (test28 measures both).
+   *
+   * @note writes through operator[], first() or last() bypass the index,
+   * call rebuild_index() after modifying elements in place
+   */
+  auto enable_index() -> void;
+
+  /**
+   * @brief Drops the value index, find goes back to a linear scan
+   */
+  auto disable_index() -> void;
+
+  /**
+   * @brief Whether find is currently served by the value index
+   */
+  [[nodiscard]] auto is_indexed() const noexcept -> bool;
+
+  /**
+   * @brief Recomputes the value index (if indexed) and the node summaries
+   * from scratch
+   */
+  auto rebuild_index() -> void;
+
+  /**
+   * @brief Handle to the element at the given index that keeps referring to
+   * it through inserts, erases, splits and compaction, until it is erased
+   *
+   * The first handle sets up a handle table, from then on every node keeps
+   * back-pointers to the handles of its elements and moves them along with
+   * the elements. Each call gives a new handle, release it once unused.
+   *
+   * @throws as Policy::Checks unless index < size()
+   */
+  [[nodiscard]] auto handle(usize index) -> LariatHandle;
+
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto handle(Index index) -> LariatHandle {
+    return handle(static_cast<usize>(index));
+  }
+
+  /**
+   * @brief Gives the slot of a handle back, the element itself stays
+   */
+  auto release(LariatHandle handle) -> void;
+
+  /**
+   * @brief Whether the element of a handle is still in the list
+   */
+  [[nodiscard]] auto is_valid(LariatHandle handle) const noexcept -> bool;
+
+  /**
+   * @brief Current index of the element of a handle, or npos if it was
+   * erased, O(nodes in front of it)
+   */
+  [[nodiscard]] auto index_of(LariatHandle handle) const -> usize;
+
+  /**
+   * @brief Element of a handle, O(1)
+   *
+   * @throws LariatException E_BAD_HANDLE if the element was erased
+   */
+  [[nodiscard]] auto get(LariatHandle handle) -> T&;
+
+  /**
+   * @brief Element of a handle, O(1)
+   *
+   * @throws LariatException E_BAD_HANDLE if the element was erased
+   */
+  [[nodiscard]] auto get(LariatHandle handle) const -> const T&;
+
+  /**
+   * @brief Approximate number of heap bytes used by the value index
+   */
+  [[nodiscard]] auto index_memory() const -> usize;
+
+  /**
+   * @brief Per node cache kept by Policy::Summary
+   */
+  using SummaryValue = typename Policy::Summary::Value;
+
+  /**
+   * @brief Node found by seek_summary
+   */
+  struct SummaryHit {
+    // first item of the node, end() if no node matched
+    const_iterator first;
+
+    // global index of first
+    usize offset;
+
+    // summary of the items before first
+    SummaryValue before;
+  };
+
+  /**
+   * @brief Summary of the whole list
+   */
+  [[nodiscard]] auto summary() const -> SummaryValue;
+
+  /**
+   * @brief First node whose running totals satisfy pred(items, summary), both
+   * taken over the list up to and including that node
+   *
+   * pred must be monotone (false for a prefix of the nodes, then true). The
+   * running totals live in a tree over the node summaries that inserts and
+   * erases update in O(log nodes), so seeks between edits cost O(log nodes).
+   * Only adding or removing nodes (splits, unlinks, compaction) makes the
+   * next query rebuild the tree, O(nodes) pointer hops without looking at
+   * the items.
+   *
+   * @note writes through operator[], first() or last() bypass the summaries,
+   * call rebuild_index() after modifying elements in place
+   * @note a query that rebuilds the tree writes to it, so const queries from
+   * several threads are only safe once a query ran after the last mutation
+   */
+  template<typename Pred>
+  [[nodiscard]] auto seek_summary(Pred pred) const -> SummaryHit;
+
+  /**
+   * @brief Summary of the items [first, last), e.g. their sum, minimum or
+   * maximum with a LariatAggregatePolicy
+   *
+   * Only the nodes at either end are read item by item, the whole nodes in
+   * between contribute their cached summary, and the first node is found
+   * through the seek_summary directory.
+   *
+   * @throws as Policy::Checks unless first <= last <= size()
+   */
+  [[nodiscard]] auto range_query(usize first, usize last) const
+    -> SummaryValue;
+
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto range_query(Index first, Index last) const
+    -> SummaryValue {
+    return range_query(static_cast<usize>(first), static_cast<usize>(last));
+  }
+
+  /**
+   * @brief Counters (when Policy::Stats counts) and node occupancy
+   */
+  [[nodiscard]] auto stats() const -> LariatStatsReport;
+
+  /**
+   * @brief Zeroes the operation counters
+   */
+  auto reset_stats() noexcept -> void;
+
+  /**
+   * @brief Snapshot format version written by save
+   */
+  static constexpr u32 snapshot_version = 1;
+
+  /**
+   * @brief Writes a binary snapshot (LariatSnapshotHeader followed by one
+   * block per node: element count then the elements)
+   */
+  auto save(std::ostream& os) const -> void;
+
+  /**
+   * @brief Replaces the contents with a snapshot written by save, the
+   * snapshot may come from a Lariat with a different node size
+   *
+   * @throws LariatException E_DATA_ERROR if the snapshot is malformed or was
+   * written for another element type, the list is left empty
+   */
+  auto load(std::istream& is) -> void;
+
+  friend std::ostream& operator<< <T, Size, Policy>(
+    std::ostream& os,
+    const Lariat<T, Size, Policy>& list
+  );
+
+  /**
+   * @brief Returns the size of this list
+   */
+  [[nodiscard]] auto size(void) const noexcept -> usize;
+
+  /**
+   * @brief Clears this list
+   */
+  auto clear() -> void; // make it empty
+
+  /**
+   * @Brief Pushes data in front reusing empty positions and delete remaining
+   * nodes
+   */
+  auto compact() -> void;
+
+  /**
+   * @brief Erases every item for which pred(item) is true in one pass over
+   * the nodes, packing the survivors into full nodes and freeing the rest
+   *
+   * If pred throws, the items not yet visited are kept and the exception is
+   * rethrown with the list packed.
+   *
+   * @return Number of erased items
+   */
+  template<typename Pred>
+  auto erase_if(Pred pred) -> usize;
+
+  /**
+   * @brief erase_if with the nodes filtered on up to threads threads, then
+   * packed on the calling thread
+   *
+   * @note pred is called concurrently and must be safe to do so
+   * @note runs on the calling thread alone once handles are in use
+   */
+  template<typename Pred>
+  auto erase_if(Pred pred, usize threads) -> usize;
+
+  /**
+   * @brief Erases every item equal to value, see erase_if
+   *
+   * @return Number of erased items
+   */
+  auto remove(const T& value) -> usize;
+
+  /**
+   * @brief Applies the operations in order, each position refers to the list
+   * as left by the operations before it
+   *
+   * A cursor remembers where the previous operation happened and walks from
+   * there (or from whichever end is closer), so a batch sorted by position
+   * costs one sweep over the nodes plus O(Size) per operation. Nodes emptied
+   * by the batch are unlinked at the end and any compact operations are
+   * carried out once, after the last operation, as is the automatic
+   * occupancy check of Policy::Occupancy.
+   *
+   * @throws as Policy::Checks on a bad position, the operations before it
+   * stay applied
+   */
+  auto apply_batch(LariatSpan<LariatBatchOp<T>> ops) -> void;
+
+  /**
+   * @brief Copies the values at indices[0, n) into out[0, n)
+   *
+   * The indices are resolved in sorted order in a single forward walk, so the
+   * cost is O(n / Size + k log k) for k indices instead of one walk from the
+   * head per index.
+   *
+   * @throws as Policy::Checks if an index is out of range, nothing is read
+   */
+  template<typename Index>
+  auto gather(const Index* indices, usize n, T* out) const -> void;
+
+  /**
+   * @brief Assigns values[j] to the element at indices[j] for j in [0, n),
+   * when an index repeats the last value given for it wins
+   *
+   * @throws as Policy::Checks if an index is out of range, nothing is written
+   */
+  template<typename Index>
+  auto scatter(const Index* indices, const T* values, usize n) -> void;
+
+  [[nodiscard]] auto begin() noexcept -> iterator;
+
+  [[nodiscard]] auto end() noexcept -> iterator;
+
+  [[nodiscard]] auto begin() const noexcept -> const_iterator;
+
+  [[nodiscard]] auto end() const noexcept -> const_iterator;
+
+  [[nodiscard]] auto cbegin() const noexcept -> const_iterator;
+
+  [[nodiscard]] auto cend() const noexcept -> const_iterator;
+
+  /**
+   * @brief Forward iterator over the contiguous runs of items, yielding
+   * LariatSpan<Value> (Value is T or const T)
+   */
+  template<typename Value>
+  class ChunkIterator {
+  public:
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = LariatSpan<Value>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = LariatSpan<Value>;
+
+    ChunkIterator() noexcept = default;
+
+    [[nodiscard]] auto operator*() const noexcept -> LariatSpan<Value> {
+      return {&(*node_)[index_], node_->run_length(index_)};
+    }
+
+    auto operator++() noexcept -> ChunkIterator& {
+      index_ += node_->run_length(index_);
+      if (index_ == node_->count) {
+        node_ = node_->next;
+        index_ = 0;
+      }
+      return *this;
+    }
+
+    auto operator++(int) noexcept -> ChunkIterator {
+      ChunkIterator before{*this};
+      ++*this;
+      return before;
+    }
+
+    [[nodiscard]] auto operator==(const ChunkIterator& rhs) const noexcept
+      -> bool {
+      return node_ == rhs.node_ and index_ == rhs.index_;
+    }
+
+    [[nodiscard]] auto operator!=(const ChunkIterator& rhs) const noexcept
+      -> bool {
+      return not(*this == rhs);
+    }
+
+  private:
+
+    friend class Lariat;
+
+    using Node = std::conditional_t<std::is_const_v<Value>, const LNode, LNode>;
+
+    ChunkIterator(Node* node, usize index) noexcept:
+        node_{node}, index_{index} {}
+
+    Node* node_{nullptr};
+
+    // local index of the first item of the current run
+    usize index_{0};
+  };
+
+  /**
+   * @brief Range of ChunkIterator, see chunks
+   */
+  template<typename Value>
+  struct ChunkRange {
+    ChunkIterator<Value> first;
+
+    [[nodiscard]] auto begin() const noexcept -> ChunkIterator<Value> {
+      return first;
+    }
+
+    [[nodiscard]] auto end() const noexcept -> ChunkIterator<Value> {
+      return {};
+    }
+  };
+
+  /**
+   * @brief Calls fn(LariatSpan<const T>) for every contiguous run of items,
+   * in order, without copying them
+   */
+  template<typename Fn>
+  auto for_each_chunk(Fn&& fn) const -> void;
+
+  /**
+   * @brief Calls fn(LariatSpan<T>) for every contiguous run of items, in
+   * order, the items may be modified in place
+   */
+  template<typename Fn>
+  auto for_each_chunk(Fn&& fn) -> void;
+
+  /**
+   * @brief The runs for_each_chunk visits, as a range for range based for
+   */
+  [[nodiscard]] auto chunks() const noexcept -> ChunkRange<const T>;
+
+  /**
+   * @brief The runs for_each_chunk visits, as a range for range based for
+   */
+  [[nodiscard]] auto chunks() noexcept -> ChunkRange<T>;
+
+  /**
+   * @brief The items from index on that are contiguous in memory: the rest
+   * of the run holding index
+   *
+   * @throws as Policy::Checks if index is out of range
+   */
+  [[nodiscard]] auto chunk_at(usize index) const -> LariatSpan<const T>;
+
+  /**
+   * @brief The items from index on that are contiguous in memory: the rest
+   * of the run holding index
+   *
+   * @throws as Policy::Checks if index is out of range
+   */
+  [[nodiscard]] auto chunk_at(usize index) -> LariatSpan<T>;
+
+private:
 
-template<typename T, usize Size>
-std::ostream& operator<<(std::ostream& os, const Lariat<T, Size>& rhs);
+  /**
+   * @brief Stand-in for the directory leaf of a node without a summary
+   */
+  struct NoSummaryRank {};
 
-/**
- * @brief Rope Data structure
- */
-template<typename T, usize Size>
-class Lariat {
-public:
+  using SummaryRank =
+    std::conditional_t<Policy::Summary::enabled, usize, NoSummaryRank>;
 
-  template<typename S, usize OtherSize>
-  friend class Lariat;
+  /**
+   * @brief Individual node in the structure
+   */
+  struct LNode : Policy::template Storage<T, Size> {
+    LNode* next = nullptr;
+    LNode* prev = nullptr;
+
+    // global index of the first item, only meaningful while the list is
+    // indexed
+    usize offset = 0;
+
+    // Policy::Summary of the items, takes no space without a summary
+    [[no_unique_address]] typename Policy::Summary::Value summary{
+      Policy::Summary::identity()
+    };
+
+    // leaf of the node in the summary directory, only meaningful while the
+    // directory is fresh
+    [[no_unique_address]] SummaryRank rank{};
+
+    auto is_full() const noexcept -> bool;
+  };
 
   /**
-   * @brief Default constructor
+   * @brief Position of the last operation of a batch: a node and the global
+   * index of its first item
    */
-  Lariat();
+  struct Cursor {
+    LNode* node;
+    usize offset;
+  };
 
   /**
-   * @brief Copy constructor
+   * @brief Runs Policy::prefetch_distance nodes ahead of a forward walk,
+   * loading the node headers before the walk reaches them
    */
-  Lariat(const Lariat& rhs);
+  struct Lookahead {
+    const LNode* node;
+
+    /**
+     * @brief Starts ahead of from, unless the walk is not known to take more
+     * than Policy::prefetch_distance hops (it would only load nodes past its
+     * target then)
+     *
+     * @param hops Lower bound of the hops left, e.g. items left / Size
+     */
+    Lookahead(const LNode* from, usize hops) noexcept;
+
+    /**
+     * @brief Follows the walk by one node
+     */
+    auto step() noexcept -> void;
+  };
 
   /**
-   * @brief Copy constructor from another lariat type
-   *
-   * @tparam S Other type that can be casted to T
-   * @param rhs other instance of a lariat type
+   * @brief Result given with find_element
+   */
+  struct FindResult {
+    LNode& node{nullptr};
+    usize index{0};
+  };
+
+  /**
+   * @brief Value -> node index backing find, see enable_index
    */
-  template<typename S, usize OtherSize>
-  Lariat(const Lariat<S, OtherSize>& rhs);
+  struct ValueIndex;
 
-  Lariat(Lariat&&) = delete;
+  /**
+   * @brief Slots behind LariatHandle and the back-pointers of every node,
+   * see handle
+   */
+  struct HandleTable;
 
   /**
-   * @brief Destructor
+   * @brief Global index and slot of a handle while elements move in bulk
    */
-  ~Lariat();
+  struct PlacedHandle {
+    usize global;
+    u32 slot;
+  };
 
   /**
-   * @brief Copy assignment
+   * @brief Node embedded in the object when Policy::inline_node is set
    */
-  auto operator=(const Lariat& rhs) -> Lariat&;
+  struct InlineNode {
+    LNode node{};
+
+    // whether node is currently linked into the list
+    bool used{false};
+  };
 
   /**
-   * @brief Copy assignment
+   * @brief Stand-in for InlineNode that takes no space
    */
-  template<typename S, usize OtherSize>
-  auto operator=(const Lariat<S, OtherSize>& rhs) -> Lariat&;
+  struct NoInlineNode {};
 
-  auto operator=(Lariat&&) -> Lariat& = delete;
+  using InlineSlot =
+    std::conditional_t<Policy::inline_node, InlineNode, NoInlineNode>;
 
   /**
-   * @brief Insert a value into the given index
+   * @brief Hysteresis state of automatic compaction
+   */
+  struct AutoCompactState {
+    // cleared by a compaction, set again above the high water mark
+    bool armed{true};
+  };
+
+  /**
+   * @brief Stand-in for AutoCompactState that takes no space
+   */
+  struct ManualCompactState {};
+
+  using CompactState = std::conditional_t<
+    Policy::Occupancy::automatic,
+    AutoCompactState,
+    ManualCompactState>;
+
+  /**
+   * @brief Tree of the node summaries, see seek_summary
    *
-   * @param index_signed signed index, this should be unsigned but I can't
-   * change the interface
-   * @param value Value to insert
+   * A complete binary tree stored as an array: the leaves from `leaves` on
+   * hold the nodes in list order (padded with empty leaves), every inner
+   * entry i totals its children 2i and 2i + 1. A node whose items change
+   * updates its leaf and the entries above it, only adding or removing nodes
+   * leaves the tree stale until the next query rebuilds it.
+   */
+  struct SummaryDirectory {
+    struct Entry {
+      // items and summary of the nodes below the entry
+      usize items;
+      SummaryValue total;
+    };
+
+    SummaryDirectory() = default;
+
+    // the leaves point into one list, copies and moves start over
+    SummaryDirectory(const SummaryDirectory&) noexcept {}
+
+    auto operator=(const SummaryDirectory&) noexcept -> SummaryDirectory& {
+      fresh = false;
+      return *this;
+    }
+
+    // node of every leaf
+    std::vector<LNode*> nodes{};
+
+    std::vector<Entry> tree{};
+
+    // index of the first leaf, a power of 2
+    usize leaves{0};
+
+    // whether the leaves match the nodes
+    bool fresh{false};
+  };
+
+  /**
+   * @brief Stand-in for SummaryDirectory that takes no space
    */
-  auto insert(int index_signed, const T& value) -> void;
+  struct NoSummaryDirectory {};
+
+  using SummaryCache = std::conditional_t<
+    Policy::Summary::enabled,
+    SummaryDirectory,
+    NoSummaryDirectory>;
 
   /**
-   * @brief Pushes a value to the end of the list
+   * @brief Factory method for LNode
    */
-  auto push_back(const T& value) -> void;
+  [[nodiscard]] auto make_node(LNode* prev = nullptr, LNode* next = nullptr)
+    const -> LNode*;
 
   /**
-   * @brief Pushes a value to the beginning of the list
+   * @brief Counterpart of make_node
    */
-  auto push_front(const T& value) -> void;
+  auto destroy_node(LNode* node) const noexcept -> void;
 
   /**
-   * @brief Erases value at the given index
+   * @brief Takes the nodes of rhs (which must be empty of its own), moving
+   * the contents of its inline node into ours
+   */
+  auto take(Lariat& rhs) -> void;
+
+  /**
+   * @brief Fills this (empty) list with the converted items of rhs, allocating
+   * the nodes up front and converting whole runs at a time
+   */
+  template<typename S, usize OtherSize, typename OtherPolicy>
+  auto convert_from(const Lariat<S, OtherSize, OtherPolicy>& rhs) -> void;
+
+  /**
+   * @brief Compacts when Policy::Occupancy asks for it, called after every
+   * public operation that can lower the fill factor
+   */
+  auto check_occupancy() -> void;
+
+  /**
+   * @brief push_back without the occupancy check, for apply_batch whose
+   * cursor must not see nodes freed by a compaction
+   */
+  auto append(const T& value) -> void;
+
+  /**
+   * @brief push_front without the occupancy check, see append
+   */
+  auto prepend(const T& value) -> void;
+
+  /**
+   * @brief Removes an (empty) node from the chain and destroys it
+   */
+  auto unlink(LNode& node) noexcept -> void;
+
+  /**
+   * @brief Splits node into 2 roughly equal sized nodes
+   */
+  auto split(LNode& node) -> void;
+
+  /**
+   * @brief Moves the items [index, count) of node to a new node behind it
+   */
+  auto split_at(LNode& node, usize index) -> void;
+
+  /**
+   * @brief Inserts value before the local index of a node, splitting the node
+   * if it is full
    *
-   * @param index_signed signed index, this should be unsigned but I can't
-   * change the interface
+   * @param global Global index the value will end up at
+   * @return Where the value was placed
    */
-  auto erase(int index_signed) -> void;
+  auto insert_at(LNode& node, usize index, usize global, const T& value)
+    -> FindResult;
 
   /**
-   * @brief Removes a value from the end of the list
+   * @brief Splits a full node while inserting value at the local index
    */
-  auto pop_back() -> void;
+  auto split_insert(LNode& node, usize index, const T& value) -> FindResult;
 
   /**
-   * @brief Removes a value from the beginning of the list
+   * @brief Removes the value at the local index of a node, unlinking the node
+   * if it becomes empty
    */
-  auto pop_front() -> void;
+  auto remove_at(
+    LNode& node,
+    usize index,
+    usize global,
+    bool unlink_empty = true
+  ) -> void;
 
   /**
-   * @brief Gives the value at the given index
+   * @brief Moves the items front to back into full nodes, dropping those for
+   * which pred(item) is true, and frees the nodes left over
    *
-   * @param index_signed signed index, this should be unsigned but I can't
-   * change the interface
+   * @return Number of dropped items
    */
-  [[nodiscard]] auto operator[](int index_signed) -> T&;
+  template<typename Pred>
+  auto pack_if(Pred& pred) -> usize;
 
   /**
-   * @brief Gives the value at the given index
+   * @brief Drops the items of one node for which pred(item) is true, keeping
+   * the order of the others, the node may be left empty
    *
-   * @param index_signed signed index, this should be unsigned but I can't
-   * change the interface
+   * Once failure holds an exception from pred, the remaining items are kept.
+   * Items moved are added to moved.
+   *
+   * @return Number of dropped items
    */
-  [[nodiscard]] auto operator[](int index_signed) const -> const T&;
+  template<typename Pred>
+  static auto filter_node(
+    LNode& node,
+    Pred& pred,
+    usize& moved,
+    std::exception_ptr& failure
+  ) -> usize;
 
   /**
-   * @brief Gets the first element of the list, throws if empty
+   * @brief Locates the element with the given global index (below size()),
+   * walking from the cursor or from the closer end of the list
    */
-  [[nodiscard]] auto first() -> T&;
+  [[nodiscard]] auto seek(Cursor& cursor, usize i) const noexcept
+    -> FindResult;
 
   /**
-   * @brief Gets the first element of the list, throws if empty
+   * @brief Checks every index and returns the positions of indices[0, n) in
+   * increasing index order (ties keep their order)
    */
-  [[nodiscard]] auto first() const -> const T&;
+  template<typename Index>
+  [[nodiscard]] auto sorted_order(const Index* indices, usize n) const
+    -> std::vector<usize>;
 
   /**
-   * @brief Gets the last element of the list, throws if empty
+   * @brief Unlinks the nodes a batch left empty
    */
-  [[nodiscard]] auto last() -> T&;
+  auto unlink_empty() noexcept -> void;
 
   /**
-   * @brief Gets the last element of the list, throws if empty
+   * @brief Value index and summary bookkeeping after node[index] was inserted
    */
-  [[nodiscard]] auto last() const -> const T&;
+  auto index_insert(LNode& node, usize index, usize global) -> void;
 
-  // returns index, size (one past last) if not found
-  [[nodiscard]] auto find(const T& value) const -> u32;
+  /**
+   * @brief Value index and summary bookkeeping before node[index] is removed
+   */
+  auto index_erase(LNode& node, usize index, usize global) -> void;
 
-  friend std::ostream& operator<< <T, Size>(
-    std::ostream& os,
-    const Lariat<T, Size>& list
-  );
+  /**
+   * @brief Moves n values into node in front of its item index with one
+   * shift and does the summary and handle bookkeeping, the node must have
+   * room
+   */
+  auto fill_node(LNode& node, usize index, const T* values, usize n) -> void;
 
   /**
-   * @brief Returns the size of this list
+   * @brief Takes the items [index, index + n) out of node with one shift,
+   * retiring their handles
    */
-  [[nodiscard]] auto size(void) const -> usize;
+  auto drain_node(LNode& node, usize index, usize n) -> void;
 
   /**
-   * @brief Clears this list
+   * @brief Handle bookkeeping after the n items from node[index] on were
+   * inserted, the handles behind them move up
    */
-  auto clear() -> void; // make it empty
+  auto handles_insert(LNode& node, usize index, usize n = 1) -> void;
 
   /**
-   * @Brief Pushes data in front reusing empty positions and delete remaining
-   * nodes
+   * @brief Handle bookkeeping before the n items from node[index] on are
+   * removed, their handles go stale and the ones behind them move down
    */
-  auto compact() -> void;
+  auto handles_erase(LNode& node, usize index, usize n = 1) -> void;
 
-private:
+  /**
+   * @brief Value index, summary and handle bookkeeping after node was split
+   * into node and next
+   */
+  auto index_split(LNode& node, LNode& next) -> void;
 
   /**
-   * @brief Individual node in the structure
+   * @brief Slot of a handle whose element is still in the list, or npos
    */
-  struct LNode {
-    LNode* next = nullptr;
-    LNode* prev = nullptr;
+  [[nodiscard]] auto live_slot(LariatHandle handle) const noexcept -> usize;
 
-    // number of items currently in the node
-    usize count = 0;
+  /**
+   * @brief Frees the slot of a handle, bumping its generation so that
+   * copies of the handle go stale
+   */
+  auto retire_handle(u32 slot) -> void;
 
-    auto is_full() const -> bool;
+  /**
+   * @brief Takes every handle off its node, in list order, before elements
+   * are moved in bulk (empty without a handle table)
+   */
+  [[nodiscard]] auto collect_handles() -> std::vector<PlacedHandle>;
 
-    T values[Size];
-  };
+  /**
+   * @brief Attaches collected handles to the nodes now holding their global
+   * indices
+   */
+  auto place_handles(const std::vector<PlacedHandle>& placed) -> void;
 
   /**
-   * @brief Result given with find_element
+   * @brief Recomputes the summary of one node from its items, leaving out
+   * the item at skip
    */
-  struct FindResult {
-    LNode& node{nullptr};
-    usize index{0};
-  };
+  static auto summarize(LNode& node, usize skip = npos) -> void;
 
   /**
-   * @brief Factory method for LNode
+   * @brief Rebuilds the seek_summary directory if a node was added or removed
+   * since it was built
    */
-  [[nodiscard]] auto make_node(LNode* prev = nullptr, LNode* next = nullptr)
-    const -> LNode*;
+  auto refresh_directory() const -> void;
 
   /**
-   * @brief Shifts all elemenets in the node up , starting at the given index
+   * @brief Brings the directory leaf of node up to date with its summary and
+   * the given item count, unless the directory is stale anyway
    */
-  auto shift_up(LNode& node, usize index) -> void;
+  auto update_directory(const LNode& node, usize items) const -> void;
 
   /**
-   * @brief Shifts all elements in the node down , starting at the given index
+   * @brief find_element through a fresh directory, O(log nodes)
    */
-  auto shift_down(LNode& node, usize index) -> void;
+  [[nodiscard]] auto seek_directory(usize i) const noexcept -> FindResult;
 
   /**
-   * @brief Splits node into 2 roughly equal sized nodes
+   * @brief Global index of the first element of a node, refreshing the cached
+   * node offsets if they went stale
    */
-  auto split(LNode& node) -> void;
+  [[nodiscard]] auto index_offset(const LNode& node) const noexcept -> usize;
 
   /**
-   * @brief Locates the element with the given global index
+   * @brief Locates the element with the given global index, which must be
+   * below size()
    *
    * @param i Global index into this list
    */
-  [[nodiscard]] auto find_element(usize i) const -> FindResult;
+  [[nodiscard]] auto find_element(usize i) const noexcept -> FindResult;
 
   /**
    * @brief Points to the first node
@@ -343,13 +2172,417 @@ private:
    * @brief The size of the array within the nodes
    */
   usize asize_{0};
+
+  /**
+   * @brief Optional value index, nullptr unless enable_index was called
+   */
+  ValueIndex* index_{nullptr};
+
+  /**
+   * @brief Optional handle table, nullptr until the first handle
+   */
+  HandleTable* handles_{nullptr};
+
+  /**
+   * @brief Operation counters, takes no space with LariatNoStats
+   */
+  [[no_unique_address]] mutable typename Policy::Stats stats_{};
+
+  /**
+   * @brief Node handed out by make_node before any heap node, takes no space
+   * unless Policy::inline_node is set
+   */
+  [[no_unique_address]] mutable InlineSlot inline_{};
+
+  /**
+   * @brief Takes no space unless Policy::Occupancy is automatic
+   */
+  [[no_unique_address]] CompactState compact_state_{};
+
+  /**
+   * @brief Directory behind seek_summary, takes no space without a summary
+   */
+  [[no_unique_address]] mutable SummaryCache directory_{};
+};
+
+/**
+ * @brief Bidirectional iterator over the items of a Lariat
+ *
+ * It is a segmented iterator: segment() is the contiguous run it points into,
+ * and the algorithm overloads below (copy, fill, equal, ...) go through
+ * LariatSegments a run at a time, so the run loops compile to memmove,
+ * memset or vector code.
+ */
+template<typename T, usize Size, typename Policy, bool Const>
+class LariatIterator {
+  using List = std::conditional_t<
+    Const,
+    const Lariat<T, Size, Policy>,
+    Lariat<T, Size, Policy>>;
+
+  using Node = std::conditional_t<
+    Const,
+    const typename Lariat<T, Size, Policy>::LNode,
+    typename Lariat<T, Size, Policy>::LNode>;
+
+public:
+
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<Const, const T*, T*>;
+  using reference = std::conditional_t<Const, const T&, T&>;
+
+  LariatIterator() noexcept = default;
+
+  /**
+   * @brief iterator to const_iterator
+   */
+  template<bool Other, typename = std::enable_if_t<Const and not Other>>
+  LariatIterator(const LariatIterator<T, Size, Policy, Other>& rhs) noexcept:
+      list_{rhs.list_}, node_{rhs.node_}, index_{rhs.index_} {}
+
+  [[nodiscard]] auto operator*() const noexcept -> reference {
+    return (*node_)[index_];
+  }
+
+  [[nodiscard]] auto operator->() const noexcept -> pointer {
+    return &(*node_)[index_];
+  }
+
+  auto operator++() noexcept -> LariatIterator&;
+
+  auto operator++(int) noexcept -> LariatIterator;
+
+  auto operator--() noexcept -> LariatIterator&;
+
+  auto operator--(int) noexcept -> LariatIterator;
+
+  [[nodiscard]] auto operator==(const LariatIterator& rhs) const noexcept
+    -> bool {
+    return node_ == rhs.node_ and index_ == rhs.index_;
+  }
+
+  [[nodiscard]] auto operator!=(const LariatIterator& rhs) const noexcept
+    -> bool {
+    return not(*this == rhs);
+  }
+
+  /**
+   * @brief The items from this one to the end of its contiguous run, empty
+   * at the end of the list
+   */
+  [[nodiscard]] auto segment() const noexcept -> LariatSpan<
+    std::remove_reference_t<reference>>;
+
+private:
+
+  template<typename U, usize OtherSize, typename OtherPolicy, bool Other>
+  friend class LariatIterator;
+
+  friend class Lariat<T, Size, Policy>;
+
+  friend struct LariatSegments;
+
+  LariatIterator(List* list, Node* node, usize index) noexcept:
+      list_{list}, node_{node}, index_{index} {}
+
+  // owner, for stepping back from end()
+  List* list_{nullptr};
+
+  // nullptr at end()
+  Node* node_{nullptr};
+
+  usize index_{0};
+};
+
+/**
+ * @brief Run at a time traversal behind the Lariat algorithm overloads
+ */
+struct LariatSegments {
+  /**
+   * @brief Calls fn(pointer, n) for the runs of [first, last), fn returns how
+   * many of the n items it consumed and consuming fewer ends the walk
+   *
+   * A default constructed iterator as last walks to the end of the list.
+   *
+   * @return Position after the last consumed item
+   */
+  template<typename It, typename Fn>
+  static auto for_each_run(It first, const It& last, Fn&& fn) -> It;
+
+  /**
+   * @brief Walks from first1 and first2 in lock step, calling fn(pointer1,
+   * pointer2, n) for the longest stretches that are contiguous on both sides,
+   * until either list ends or fn consumes fewer than n items
+   */
+  template<typename It1, typename It2, typename Fn>
+  static auto for_each_run_pair(It1 first1, It2 first2, Fn&& fn) -> void;
+};
+
+/**
+ * @brief Copies [first, last) to out, a run at a time
+ */
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename OutputIt>
+auto copy(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  OutputIt out
+) -> OutputIt;
+
+/**
+ * @brief Copies [first, last) into the list at out, a run at a time
+ */
+template<typename InputIt, typename T, usize Size, typename Policy>
+auto copy(
+  InputIt first,
+  InputIt last,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false>;
+
+/**
+ * @brief Copies between two lists, a run at a time
+ */
+template<
+  typename S,
+  usize OtherSize,
+  typename OtherPolicy,
+  bool Const,
+  typename T,
+  usize Size,
+  typename Policy>
+auto copy(
+  LariatIterator<S, OtherSize, OtherPolicy, Const> first,
+  LariatIterator<S, OtherSize, OtherPolicy, Const> last,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false>;
+
+/**
+ * @brief Copies n items from first to out, a run at a time
+ */
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename Count,
+  typename OutputIt>
+auto copy_n(
+  LariatIterator<T, Size, Policy, Const> first,
+  Count n,
+  OutputIt out
+) -> OutputIt;
+
+/**
+ * @brief Copies n items from first into the list at out, a run at a time
+ */
+template<
+  typename InputIt,
+  typename Count,
+  typename T,
+  usize Size,
+  typename Policy>
+auto copy_n(
+  InputIt first,
+  Count n,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false>;
+
+/**
+ * @brief Copies n items between two lists, a run at a time
+ */
+template<
+  typename S,
+  usize OtherSize,
+  typename OtherPolicy,
+  bool Const,
+  typename Count,
+  typename T,
+  usize Size,
+  typename Policy>
+auto copy_n(
+  LariatIterator<S, OtherSize, OtherPolicy, Const> first,
+  Count n,
+  LariatIterator<T, Size, Policy, false> out
+) -> LariatIterator<T, Size, Policy, false>;
+
+/**
+ * @brief Assigns value to every item of [first, last), a run at a time
+ */
+template<typename T, usize Size, typename Policy, typename U>
+auto fill(
+  LariatIterator<T, Size, Policy, false> first,
+  LariatIterator<T, Size, Policy, false> last,
+  const U& value
+) -> void;
+
+/**
+ * @brief Whether [first1, last1) equals the range starting at first2
+ */
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename InputIt>
+[[nodiscard]] auto equal(
+  LariatIterator<T, Size, Policy, Const> first1,
+  LariatIterator<T, Size, Policy, Const> last1,
+  InputIt first2
+) -> bool;
+
+/**
+ * @brief First item of [first, last) equal to value, or last
+ */
+template<typename T, usize Size, typename Policy, bool Const, typename U>
+[[nodiscard]] auto find(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  const U& value
+) -> LariatIterator<T, Size, Policy, Const>;
+
+/**
+ * @brief Folds [first, last) into init with +
+ */
+template<typename T, usize Size, typename Policy, bool Const, typename Init>
+[[nodiscard]] auto accumulate(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  Init init
+) -> Init;
+
+/**
+ * @brief Folds [first, last) into init with op
+ */
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename Init,
+  typename BinaryOp>
+[[nodiscard]] auto accumulate(
+  LariatIterator<T, Size, Policy, Const> first,
+  LariatIterator<T, Size, Policy, Const> last,
+  Init init,
+  BinaryOp op
+) -> Init;
+
+/**
+ * @brief Whether [first1, last1) orders before [first2, last2)
+ */
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  bool Const,
+  typename InputIt>
+[[nodiscard]] auto lexicographical_compare(
+  LariatIterator<T, Size, Policy, Const> first1,
+  LariatIterator<T, Size, Policy, Const> last1,
+  InputIt first2,
+  InputIt last2
+) -> bool;
+
+/**
+ * @brief Whether both lists hold equal items in the same order, node sizes
+ * and policies may differ
+ */
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+[[nodiscard]] auto operator==(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool;
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+[[nodiscard]] auto operator!=(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool;
+
+/**
+ * @brief Lexicographical order of the items, node sizes and policies may
+ * differ
+ */
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+[[nodiscard]] auto operator<(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool;
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+[[nodiscard]] auto operator>(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool;
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+[[nodiscard]] auto operator<=(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool;
+
+template<
+  typename T,
+  usize Size,
+  typename Policy,
+  usize OtherSize,
+  typename OtherPolicy>
+[[nodiscard]] auto operator>=(
+  const Lariat<T, Size, Policy>& lhs,
+  const Lariat<T, OtherSize, OtherPolicy>& rhs
+) -> bool;
+
+/**
+ * @brief Hash of the items in order, lists that compare equal hash equal
+ * whatever their node size, computed a chunk at a time
+ */
+namespace std {
+template<typename T, usize Size, typename Policy>
+struct hash<Lariat<T, Size, Policy>> {
+  [[nodiscard]] auto operator()(const Lariat<T, Size, Policy>& list) const
+    -> usize;
 };
+} // namespace std
 
 /**
  * @brief Generic swap function
  */
 template<typename T>
-auto swap(T& lhs, T& rhs) -> void;
+auto swap(T& lhs, T& rhs) noexcept(
+  std::is_nothrow_move_constructible_v<T>
+  and std::is_nothrow_move_assignable_v<T>
+) -> void;
 
 #ifndef LARIAT_CPP
   #include "lariat.cpp"
@@ -0,0 +1,623 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#define LARIAT_PAGES_CPP
+
+#ifndef LARIAT_PAGES_H
+  #include "lariat_pages.h"
+#endif
+
+template<typename T, usize Size, typename Backing>
+std::ostream& operator<<(
+  std::ostream& os,
+  const LariatPages<T, Size, Backing>& list
+) {
+  using Link = typename LariatPages<T, Size, Backing>::Link;
+
+  if (not list.is_open()) {
+    return os;
+  }
+
+  usize index = 0;
+  for (Link link = list.header().head; link; link = list.page(link).next) {
+    const auto& current = list.page(link);
+    os << "Node starting (count " << static_cast<usize>(current.count)
+       << ")\n";
+    for (usize local_index = 0; local_index < current.count; ++local_index) {
+      os << index << " -> " << current.values[local_index] << "\n";
+      ++index;
+    }
+    os << "-----------\n";
+  }
+  return os;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::is_open() const -> bool {
+  return base_ != nullptr;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::insert(
+  const usize index,
+  const T& value
+) -> void {
+  if (index == size()) {
+    push_back(value);
+    return;
+  }
+
+  if (index > size()) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+
+  if (index == 0) {
+    push_front(value);
+    return;
+  }
+
+  const FindResult result = find_element(index);
+  insert_at(result.node, result.index, value);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::push_back(const T& value) -> void {
+  require_open();
+
+  if (not header().tail) {
+    const Link link = allocate_page();
+    header().head = link;
+    header().tail = link;
+  }
+
+  const Link tail = header().tail;
+  insert_at(tail, page(tail).count, value);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::push_front(const T& value) -> void {
+  require_open();
+
+  // value may live in the region, keep it safe from a remap in split
+  const T copy = value;
+
+  if (not header().head) {
+    const Link link = allocate_page();
+    header().head = link;
+    header().tail = link;
+  } else if (page(header().head).count == Size) {
+    split(header().head);
+  }
+
+  insert_at(header().head, 0, copy);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::erase(const usize index) -> void {
+  if (index >= size()) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+
+  const FindResult result = find_element(index);
+  remove_at(result.node, result.index);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::pop_back() -> void {
+  if (size() == 0) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+
+  const Link tail = header().tail;
+  remove_at(tail, page(tail).count - 1);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::pop_front() -> void {
+  if (size() == 0) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+
+  remove_at(header().head, 0);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::operator[](const usize index) -> T& {
+  const FindResult result = find_element(index);
+  return page(result.node).values[result.index];
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::operator[](const usize index) const
+  -> const T& {
+  const FindResult result = find_element(index);
+  return page(result.node).values[result.index];
+}
+
+template<typename T, usize Size, typename Backing>
+template<typename Index, typename>
+auto LariatPages<T, Size, Backing>::insert(const Index index, const T& value)
+  -> void {
+  insert(static_cast<usize>(index), value);
+}
+
+template<typename T, usize Size, typename Backing>
+template<typename Index, typename>
+auto LariatPages<T, Size, Backing>::erase(const Index index) -> void {
+  erase(static_cast<usize>(index));
+}
+
+template<typename T, usize Size, typename Backing>
+template<typename Index, typename>
+auto LariatPages<T, Size, Backing>::operator[](const Index index) -> T& {
+  return (*this)[static_cast<usize>(index)];
+}
+
+template<typename T, usize Size, typename Backing>
+template<typename Index, typename>
+auto LariatPages<T, Size, Backing>::operator[](const Index index) const
+  -> const T& {
+  return (*this)[static_cast<usize>(index)];
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::first() const -> const T& {
+  if (not size()) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+
+  return page(header().head).values[0];
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::last() const -> const T& {
+  if (not size()) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+
+  const Page& tail = page(header().tail);
+  return tail.values[tail.count - 1];
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::find(const T& value) const -> u32 {
+  const usize i = index_of(value);
+  return static_cast<u32>(i == npos ? size() : i);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::index_of(const T& value) const -> usize {
+  usize i = 0;
+
+  if (is_open()) {
+    for (Link link = header().head; link; link = page(link).next) {
+      const Page& node = page(link);
+      for (usize j = 0; j < node.count; j++) {
+        if (node.values[j] == value) {
+          return i + j;
+        }
+      }
+      i += node.count;
+    }
+  }
+
+  return npos;
+}
+
+template<typename T, usize Size, typename Backing>
+template<typename Fn>
+auto LariatPages<T, Size, Backing>::for_each_chunk(Fn&& fn) const -> void {
+  if (not is_open()) {
+    return;
+  }
+
+  for (Link link = header().head; link; link = page(link).next) {
+    const Page& node = page(link);
+    fn(LariatSpan<const T>{node.values, node.count});
+  }
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::size() const -> usize {
+  return is_open() ? static_cast<usize>(header().size) : 0;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::node_count() const -> usize {
+  return is_open() ? static_cast<usize>(header().node_count) : 0;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::page_capacity() const -> usize {
+  return is_open() ? static_cast<usize>(header().capacity) : 0;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::clear() -> void {
+  require_open();
+
+  // every page goes back to the untouched region
+  RegionHeader& file = header();
+  file.head = 0;
+  file.tail = 0;
+  file.free_head = 0;
+  file.used = 0;
+  file.size = 0;
+  file.node_count = 0;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::compact() -> void {
+  if (size() == 0) {
+    if (is_open()) {
+      clear();
+    }
+    return;
+  }
+
+  RegionHeader& file = header();
+
+  if (file.node_count == 1 or file.size / Size >= file.node_count) {
+    return;
+  }
+
+  // the write cursor never overtakes the read cursor, so elements can be moved
+  // in place front to back
+  Link dest{file.head};
+  usize write_idx{page(dest).count};
+
+  for (Link src = page(file.head).next; src; src = page(src).next) {
+    Page& read = page(src);
+    for (usize read_idx = 0; read_idx < read.count; read_idx++) {
+      if (write_idx == Size) {
+        page(dest).count = static_cast<Count>(Size);
+        dest = page(dest).next;
+        write_idx = 0;
+      }
+      page(dest).values[write_idx++] = read.values[read_idx];
+    }
+  }
+  page(dest).count = static_cast<Count>(write_idx);
+
+  file.tail = dest;
+  Link release = page(dest).next;
+  page(dest).next = 0;
+
+  while (release) {
+    const Link next = page(release).next;
+    release_page(release);
+    release = next;
+  }
+}
+
+template<typename T, usize Size, typename Backing>
+constexpr auto LariatPages<T, Size, Backing>::page_overhead() -> usize {
+  return sizeof(Page) - sizeof(T) * Size;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::init_header() -> void {
+  RegionHeader& fresh = header();
+  fresh = RegionHeader{};
+  std::memcpy(fresh.magic, "LRMP", sizeof(fresh.magic));
+  fresh.version = region_version;
+  fresh.type_tag = LariatSerializer<T>::tag;
+  fresh.value_size = static_cast<u32>(sizeof(T));
+  fresh.node_size = Size;
+  fresh.page_size = sizeof(Page);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::check_header(const std::string& source)
+  const -> void {
+  if (bytes_ < header_bytes) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      source + " is not a mapped Lariat"
+    };
+  }
+
+  const RegionHeader& existing = header();
+  if (std::memcmp(existing.magic, "LRMP", sizeof(existing.magic)) != 0
+      or existing.version != region_version) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      source + " is not a mapped Lariat"
+    };
+  }
+
+  if (existing.type_tag != LariatSerializer<T>::tag
+      or existing.value_size != sizeof(T) or existing.node_size != Size
+      or existing.page_size != sizeof(Page)) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      source + " holds a Lariat of another type or node size"
+    };
+  }
+
+  // divided rather than multiplied out, a huge capacity cannot wrap around
+  if (existing.capacity > static_cast<Link>(-1)
+      or existing.capacity > (bytes_ - header_bytes) / sizeof(Page)
+      or existing.used > existing.capacity
+      or existing.head > existing.capacity
+      or existing.tail > existing.capacity
+      or existing.free_head > existing.capacity) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      source + " is malformed"
+    };
+  }
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::check_links(const std::string& source)
+  const -> void {
+  const RegionHeader& file = header();
+  const auto malformed = [&source] {
+    return LariatException{
+      LariatException::E_DATA_ERROR,
+      source + " is malformed"
+    };
+  };
+
+  // pages above used were never handed out, so no chain may reach them
+  if (file.used > file.capacity or file.head > file.used
+      or file.tail > file.used or file.free_head > file.used
+      or (file.head == 0) != (file.tail == 0)) {
+    throw malformed();
+  }
+
+  std::vector<bool> seen(static_cast<usize>(file.used) + 1);
+
+  u64 items{0};
+  u64 pages{0};
+  Link prev{0};
+  for (Link link = file.head; link; link = page(link).next) {
+    if (link > file.used or seen[link]) {
+      throw malformed();
+    }
+    seen[link] = true;
+
+    const Page& node = page(link);
+    if (node.prev != prev or node.count == 0 or node.count > Size) {
+      throw malformed();
+    }
+
+    items += node.count;
+    pages++;
+    prev = link;
+  }
+
+  if (prev != file.tail or items != file.size or pages != file.node_count) {
+    throw malformed();
+  }
+
+  for (Link link = file.free_head; link; link = page(link).next) {
+    if (link > file.used or seen[link]) {
+      throw malformed();
+    }
+    seen[link] = true;
+  }
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::header() const -> RegionHeader& {
+  return *reinterpret_cast<RegionHeader*>(base_);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::page(const Link link) const -> Page& {
+  return *reinterpret_cast<Page*>(
+    base_ + header_bytes + (static_cast<usize>(link) - 1) * sizeof(Page)
+  );
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::allocate_page() -> Link {
+  Link link = header().free_head;
+
+  if (link) {
+    header().free_head = page(link).next;
+  } else {
+    if (header().used == header().capacity) {
+      grow(std::max<u64>(16, header().capacity * 2));
+    }
+    link = static_cast<Link>(++header().used);
+  }
+
+  Page& fresh = page(link);
+  fresh.next = 0;
+  fresh.prev = 0;
+  fresh.count = 0;
+  header().node_count++;
+
+  return link;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::release_page(const Link link) -> void {
+  page(link).next = header().free_head;
+  header().free_head = link;
+  header().node_count--;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::grow(const u64 capacity) -> void {
+  if (capacity > static_cast<Link>(-1)) {
+    throw LariatException{LariatException::E_NO_MEMORY};
+  }
+
+  static_cast<Backing&>(*this).resize_region(
+    header_bytes + static_cast<usize>(capacity) * sizeof(Page)
+  );
+
+  header().capacity = capacity;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::require_open() const -> void {
+  if (not is_open()) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      "Lariat pages are not open"
+    };
+  }
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::unlink(const Link link) -> void {
+  RegionHeader& file = header();
+  const Page& node = page(link);
+
+  if (node.prev) {
+    page(node.prev).next = node.next;
+  } else {
+    file.head = node.next;
+  }
+
+  if (node.next) {
+    page(node.next).prev = node.prev;
+  } else {
+    file.tail = node.prev;
+  }
+
+  release_page(link);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::split(const Link link) -> void {
+  const Link next_link = allocate_page();
+
+  Page& node = page(link);
+  Page& next = page(next_link);
+
+  next.prev = link;
+  next.next = node.next;
+  if (node.next) {
+    page(node.next).prev = next_link;
+  } else {
+    header().tail = next_link;
+  }
+  node.next = next_link;
+
+  const usize sep_index = (node.count + 1) / 2;
+
+  std::copy(node.values + sep_index, node.values + node.count, next.values);
+
+  next.count = static_cast<Count>(node.count - sep_index);
+  node.count = static_cast<Count>(sep_index);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::insert_at(
+  const Link link,
+  const usize index,
+  const T& value
+) -> void {
+  if (page(link).count == Size) {
+    split_insert(link, index, value);
+  } else {
+    Page& node = page(link);
+    std::copy_backward(
+      node.values + index,
+      node.values + node.count,
+      node.values + node.count + 1
+    );
+    node.values[index] = value;
+    node.count++;
+  }
+
+  header().size++;
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::split_insert(
+  const Link link,
+  const usize index,
+  const T& value
+) -> void {
+  // value may live in the region, keep it safe from the remap
+  const T copy = value;
+  const Link next_link = allocate_page();
+
+  Page& node = page(link);
+  Page& next = page(next_link);
+
+  next.prev = link;
+  next.next = node.next;
+  if (node.next) {
+    page(node.next).prev = next_link;
+  } else {
+    header().tail = next_link;
+  }
+  node.next = next_link;
+
+  // virtual layout is values[0, index) value values[index, count)
+  const usize total = node.count + 1;
+  const usize sep_index = (total + 1) / 2;
+
+  if (index < sep_index) {
+    std::copy(
+      node.values + sep_index - 1,
+      node.values + node.count,
+      next.values
+    );
+    std::copy_backward(
+      node.values + index,
+      node.values + sep_index - 1,
+      node.values + sep_index
+    );
+    node.values[index] = copy;
+  } else {
+    T* out =
+      std::copy(node.values + sep_index, node.values + index, next.values);
+    *out++ = copy;
+    std::copy(node.values + index, node.values + node.count, out);
+  }
+
+  next.count = static_cast<Count>(total - sep_index);
+  node.count = static_cast<Count>(sep_index);
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::remove_at(
+  const Link link,
+  const usize index
+) -> void {
+  Page& node = page(link);
+
+  std::copy(
+    node.values + index + 1,
+    node.values + node.count,
+    node.values + index
+  );
+  node.count--;
+  header().size--;
+
+  if (node.count == 0) {
+    unlink(link);
+  }
+}
+
+template<typename T, usize Size, typename Backing>
+auto LariatPages<T, Size, Backing>::find_element(const usize i) const
+  -> FindResult {
+  if (i >= size()) {
+    throw LariatException{LariatException::E_BAD_INDEX};
+  }
+
+  usize index{i};
+
+  for (Link link = header().head; link; link = page(link).next) {
+    const usize count = page(link).count;
+    if (index < count) {
+      return {link, index};
+    }
+
+    index -= count;
+  }
+
+  throw LariatException{LariatException::E_BAD_INDEX};
+}
@@ -0,0 +1,357 @@
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LARIAT_PAGES_H
+#define LARIAT_PAGES_H
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lariat.h"
+
+#include <string>
+
+// forward declaration for 1-1 operator<<
+template<typename T, usize Size, typename Backing>
+class LariatPages;
+
+template<typename T, usize Size, typename Backing>
+std::ostream& operator<<(
+  std::ostream& os,
+  const LariatPages<T, Size, Backing>& rhs
+);
+
+/**
+ * @brief Unrolled list engine whose nodes are fixed size pages of one
+ * contiguous region, linked by 32 bit page numbers instead of pointers
+ *
+ * The region starts with a header holding all of the list state, so it can be
+ * grown by moving it wholesale (no links need fixing up), copied with memcpy
+ * and written out or mapped back in as is. Pages released by erase/compact go
+ * to a free list that split reuses before the region is grown.
+ *
+ * Backing owns the region and must provide resize_region(bytes), which makes
+ * base_ point at (at least) bytes bytes with the old contents preserved and
+ * sets bytes_.
+ */
+template<typename T, usize Size, typename Backing>
+class LariatPages {
+public:
+
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "LariatPages stores raw values in the region"
+  );
+
+  /**
+   * @brief Whether a region is currently attached
+   */
+  [[nodiscard]] auto is_open() const -> bool;
+
+  /**
+   * @brief Insert a value into the given index
+   */
+  auto insert(usize index, const T& value) -> void;
+
+  /**
+   * @brief Insert a value into the given index, for int (the original
+   * interface) and every other integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  auto insert(Index index, const T& value) -> void;
+
+  /**
+   * @brief Pushes a value to the end of the list
+   */
+  auto push_back(const T& value) -> void;
+
+  /**
+   * @brief Pushes a value to the beginning of the list
+   */
+  auto push_front(const T& value) -> void;
+
+  /**
+   * @brief Erases value at the given index
+   */
+  auto erase(usize index) -> void;
+
+  /**
+   * @brief Erases value at the given index, for int (the original interface)
+   * and every other integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  auto erase(Index index) -> void;
+
+  /**
+   * @brief Removes a value from the end of the list
+   */
+  auto pop_back() -> void;
+
+  /**
+   * @brief Removes a value from the beginning of the list
+   */
+  auto pop_front() -> void;
+
+  /**
+   * @brief Gives the value at the given index (a reference into the region)
+   */
+  [[nodiscard]] auto operator[](usize index) -> T&;
+
+  /**
+   * @brief Gives the value at the given index (a reference into the region)
+   */
+  [[nodiscard]] auto operator[](usize index) const -> const T&;
+
+  /**
+   * @brief operator[] for int (the original interface) and every other
+   * integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto operator[](Index index) -> T&;
+
+  /**
+   * @brief operator[] for int (the original interface) and every other
+   * integer type
+   */
+  template<typename Index, typename = LariatOtherIndex<Index>>
+  [[nodiscard]] auto operator[](Index index) const -> const T&;
+
+  /**
+   * @brief Gets the first element of the list, throws if empty
+   */
+  [[nodiscard]] auto first() const -> const T&;
+
+  /**
+   * @brief Gets the last element of the list, throws if empty
+   */
+  [[nodiscard]] auto last() const -> const T&;
+
+  /**
+   * @brief index_of returns this when the value is missing
+   */
+  static constexpr usize npos = static_cast<usize>(-1);
+
+  // returns index, size (one past last) if not found
+  [[nodiscard]] auto find(const T& value) const -> u32;
+
+  /**
+   * @brief Index of the first occurrence of value, or npos, find for lists
+   * past the u32 range
+   */
+  [[nodiscard]] auto index_of(const T& value) const -> usize;
+
+  /**
+   * @brief Calls fn with a LariatSpan<const T> over every page's values,
+   * pointing straight into the region
+   */
+  template<typename Fn>
+  auto for_each_chunk(Fn&& fn) const -> void;
+
+  friend std::ostream& operator<< <T, Size, Backing>(
+    std::ostream& os,
+    const LariatPages<T, Size, Backing>& list
+  );
+
+  /**
+   * @brief Returns the size of this list
+   */
+  [[nodiscard]] auto size() const -> usize;
+
+  /**
+   * @brief Number of pages holding elements
+   */
+  [[nodiscard]] auto node_count() const -> usize;
+
+  /**
+   * @brief Number of pages the region has room for (used and free)
+   */
+  [[nodiscard]] auto page_capacity() const -> usize;
+
+  /**
+   * @brief Clears this list, the region keeps its size
+   */
+  auto clear() -> void;
+
+  /**
+   * @Brief Pushes data in front reusing empty positions and releases the
+   * remaining pages to the free list
+   */
+  auto compact() -> void;
+
+  /**
+   * @brief Bytes each page spends on bookkeeping rather than values
+   */
+  static constexpr auto page_overhead() -> usize;
+
+protected:
+
+  LariatPages() = default;
+
+  LariatPages(const LariatPages&) = default;
+
+  auto operator=(const LariatPages&) -> LariatPages& = default;
+
+  ~LariatPages() = default;
+
+  /**
+   * @brief Page number of a node, 0 is null, page k starts at region offset
+   * header_bytes + (k - 1) * sizeof(Page)
+   */
+  using Link = u32;
+
+  /**
+   * @brief Number of items in a page, sized to Size
+   */
+  using Count = LariatCount<Size>;
+
+  /**
+   * @brief A node as laid out in the region
+   */
+  struct Page {
+    Link next;
+    Link prev;
+
+    // number of items currently in the node
+    Count count;
+
+    T values[Size];
+  };
+
+  /**
+   * @brief First bytes of the region
+   */
+  struct RegionHeader {
+    char magic[4];
+    u32 version;
+    u32 type_tag;
+    u32 value_size;
+    u64 node_size;
+    u64 page_size;
+
+    // number of elements
+    u64 size;
+
+    // number of pages holding elements
+    u64 node_count;
+
+    // pages the region has room for
+    u64 capacity;
+
+    // pages ever handed out, pages above this were never touched
+    u64 used;
+
+    Link head;
+    Link tail;
+
+    // chain of released pages, linked through Page::next
+    Link free_head;
+  };
+
+  /**
+   * @brief Bytes reserved in front of the first page
+   */
+  static constexpr usize header_bytes =
+    (sizeof(RegionHeader) + alignof(Page) - 1) / alignof(Page) * alignof(Page);
+
+  /**
+   * @brief Layout version of the region
+   */
+  static constexpr u32 region_version = 2;
+
+  /**
+   * @brief Result given with find_element
+   */
+  struct FindResult {
+    Link node;
+    usize index;
+  };
+
+  /**
+   * @brief Writes the header of an empty list into a freshly sized region
+   */
+  auto init_header() -> void;
+
+  /**
+   * @brief Throws E_DATA_ERROR (naming source) unless the header describes a
+   * list of this element type and node size whose capacity fits in bytes_
+   * and in a Link, with used and the header links within that capacity
+   */
+  auto check_header(const std::string& source) const -> void;
+
+  /**
+   * @brief Throws E_DATA_ERROR (naming source) unless the page chain and the
+   * free list only link pages that were handed out, have no cycles, share no
+   * page and agree with the counts in the header
+   */
+  auto check_links(const std::string& source) const -> void;
+
+  [[nodiscard]] auto header() const -> RegionHeader&;
+
+  [[nodiscard]] auto page(Link link) const -> Page&;
+
+  /**
+   * @brief Takes a page from the free list or grows the region
+   *
+   * @note may move the region, references to pages are invalidated
+   */
+  [[nodiscard]] auto allocate_page() -> Link;
+
+  /**
+   * @brief Returns a page to the free list
+   */
+  auto release_page(Link link) -> void;
+
+  /**
+   * @brief Resizes the region to hold the given number of pages
+   */
+  auto grow(u64 capacity) -> void;
+
+  /**
+   * @brief Throws if no region is attached
+   */
+  auto require_open() const -> void;
+
+  /**
+   * @brief Removes an (empty) page from the chain and releases it
+   */
+  auto unlink(Link link) -> void;
+
+  /**
+   * @brief Splits node into 2 roughly equal sized nodes
+   */
+  auto split(Link link) -> void;
+
+  /**
+   * @brief Inserts value before the local index of a node, splitting it if
+   * full
+   */
+  auto insert_at(Link link, usize index, const T& value) -> void;
+
+  /**
+   * @brief Splits a full node while inserting value at the local index
+   */
+  auto split_insert(Link link, usize index, const T& value) -> void;
+
+  /**
+   * @brief Removes the value at the local index of a node, unlinking the node
+   * if it becomes empty
+   */
+  auto remove_at(Link link, usize index) -> void;
+
+  /**
+   * @brief Locates the element with the given global index
+   */
+  [[nodiscard]] auto find_element(usize i) const -> FindResult;
+
+  /**
+   * @brief Start of the region
+   */
+  char* base_{nullptr};
+
+  /**
+   * @brief Length of the region
+   */
+  usize bytes_{0};
+};
+
+#ifndef LARIAT_PAGES_CPP
+  #include "lariat_pages.cpp"
+#endif
+
+#endif // LARIAT_PAGES_H
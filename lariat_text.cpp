@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#define LARIAT_TEXT_CPP
+
+#ifndef LARIAT_TEXT_H
+  #include "lariat_text.h"
+#endif
+
+template<usize Size>
+LariatText<Size>::LariatText(const std::string_view text) {
+  chars_.insert(usize{0}, {text.data(), text.size()});
+}
+
+template<usize Size>
+auto LariatText<Size>::size() const -> usize {
+  return chars_.size();
+}
+
+template<usize Size>
+auto LariatText<Size>::line_count() const -> usize {
+  return chars_.summary().lines + 1;
+}
+
+template<usize Size>
+auto LariatText<Size>::codepoint_count() const -> usize {
+  return chars_.summary().codepoints;
+}
+
+template<usize Size>
+auto LariatText<Size>::line_start(const usize line) const -> usize {
+  LariatTextPolicy::Checks::check(line < line_count());
+
+  if (line == 0) {
+    return 0;
+  }
+
+  const auto hit = chars_.seek_summary([line](usize, const Summary& through) {
+    return through.lines >= line;
+  });
+
+  // the newline ending the previous line is in this node
+  usize remaining = line - hit.before.lines;
+  usize offset = hit.offset;
+  LariatSegments::for_each_run(hit.first, {}, [&](const char* run, usize n) {
+    const char* const last = run + n;
+    for (const char* p = run; p != last; p++) {
+      p = static_cast<const char*>(
+        std::memchr(p, '\n', static_cast<usize>(last - p))
+      );
+      if (not p) {
+        break;
+      }
+
+      if (--remaining == 0) {
+        offset += static_cast<usize>(p - run) + 1;
+        return usize{0};
+      }
+    }
+
+    offset += n;
+    return n;
+  });
+
+  return offset;
+}
+
+template<usize Size>
+auto LariatText<Size>::offset_to_line_col(const usize offset) const
+  -> LariatTextPosition {
+  check_offset(offset);
+
+  const Summary before = prefix(offset);
+  const usize line = before.lines;
+  return {line, before.codepoints - prefix(line_start(line)).codepoints};
+}
+
+template<usize Size>
+auto LariatText<Size>::insert_text(
+  const usize offset,
+  const std::string_view text
+) -> void {
+  check_offset(offset);
+
+  chars_.insert(offset, {text.data(), text.size()});
+}
+
+template<usize Size>
+auto LariatText<Size>::erase_text(const usize offset, const usize count)
+  -> void {
+  check_offset(offset);
+
+  chars_.erase(offset, offset + std::min(count, size() - offset));
+}
+
+template<usize Size>
+auto LariatText<Size>::substr(const usize offset, const usize count) const
+  -> std::string {
+  check_offset(offset);
+
+  const usize n = std::min(count, size() - offset);
+  std::string text;
+  text.reserve(n);
+  ::copy_n(at(offset), n, std::back_inserter(text));
+  return text;
+}
+
+template<usize Size>
+auto LariatText<Size>::chars() const noexcept -> const Chars& {
+  return chars_;
+}
+
+template<usize Size>
+auto LariatText<Size>::check_offset(const usize offset) const -> void {
+  LariatTextPolicy::Checks::check(offset <= size());
+}
+
+template<usize Size>
+auto LariatText<Size>::prefix(const usize offset) const -> Summary {
+  const auto hit = chars_.seek_summary([offset](usize items, const Summary&) {
+    return items > offset;
+  });
+
+  Summary before = hit.before;
+  usize left = offset - hit.offset;
+  LariatSegments::for_each_run(hit.first, {}, [&](const char* run, usize n) {
+    const usize k = std::min(n, left);
+    for (usize j = 0; j < k; j++) {
+      LariatTextSummary::add(before, run[j]);
+    }
+    left -= k;
+    return k;
+  });
+
+  return before;
+}
+
+template<usize Size>
+auto LariatText<Size>::at(const usize offset) const ->
+  typename Chars::const_iterator {
+  const auto hit = chars_.seek_summary([offset](usize items, const Summary&) {
+    return items > offset;
+  });
+
+  usize left = offset - hit.offset;
+  return LariatSegments::for_each_run(hit.first, {}, [&](const char*, usize n) {
+    const usize k = std::min(n, left);
+    left -= k;
+    return k;
+  });
+}
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LARIAT_TEXT_H
+#define LARIAT_TEXT_H
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lariat.h"
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Line and column of a position in a LariatText, both from 0, the
+ * column counts UTF-8 code points from the start of the line
+ */
+struct LariatTextPosition {
+  usize line{0};
+  usize column{0};
+};
+
+/**
+ * @brief Text buffer over Lariat<char> whose nodes cache their newline and
+ * code point counts (LariatTextSummary)
+ *
+ * Positions are byte offsets. Line lookups bisect the running totals of the
+ * node summaries and then scan a single node, so they cost O(log nodes +
+ * Size) instead of a scan of every char. Edits go through the range insert
+ * and erase of Lariat, which move whole node sized runs and update the
+ * summary of each node they touch once.
+ */
+template<usize Size = 4096>
+class LariatText {
+public:
+
+  using Chars = Lariat<char, Size, LariatTextPolicy>;
+
+  /**
+   * @brief Creates an empty buffer
+   */
+  LariatText() = default;
+
+  /**
+   * @brief Creates a buffer holding text
+   */
+  explicit LariatText(std::string_view text);
+
+  /**
+   * @brief Number of bytes
+   */
+  [[nodiscard]] auto size() const -> usize;
+
+  /**
+   * @brief Number of lines, one more than the number of newlines
+   */
+  [[nodiscard]] auto line_count() const -> usize;
+
+  /**
+   * @brief Number of UTF-8 code points
+   */
+  [[nodiscard]] auto codepoint_count() const -> usize;
+
+  /**
+   * @brief Offset of the first byte of a line
+   *
+   * @throws LariatException E_BAD_INDEX if line >= line_count()
+   */
+  [[nodiscard]] auto line_start(usize line) const -> usize;
+
+  /**
+   * @brief Line and column of the byte at offset (offset may be size())
+   *
+   * @throws LariatException E_BAD_INDEX if offset > size()
+   */
+  [[nodiscard]] auto offset_to_line_col(usize offset) const
+    -> LariatTextPosition;
+
+  /**
+   * @brief Inserts text in front of the byte at offset (offset may be size())
+   *
+   * @throws LariatException E_BAD_INDEX if offset > size()
+   */
+  auto insert_text(usize offset, std::string_view text) -> void;
+
+  /**
+   * @brief Erases the bytes [offset, offset + count), clamped to the end
+   *
+   * @throws LariatException E_BAD_INDEX if offset > size()
+   */
+  auto erase_text(usize offset, usize count) -> void;
+
+  /**
+   * @brief Copies the bytes [offset, offset + count), clamped to the end
+   *
+   * @throws LariatException E_BAD_INDEX if offset > size()
+   */
+  [[nodiscard]] auto substr(usize offset, usize count) const -> std::string;
+
+  /**
+   * @brief The underlying list
+   */
+  [[nodiscard]] auto chars() const noexcept -> const Chars&;
+
+private:
+
+  using Summary = typename Chars::SummaryValue;
+
+  /**
+   * @brief Throws E_BAD_INDEX unless offset <= size()
+   */
+  auto check_offset(usize offset) const -> void;
+
+  /**
+   * @brief Summary of the bytes [0, offset)
+   */
+  [[nodiscard]] auto prefix(usize offset) const -> Summary;
+
+  /**
+   * @brief Iterator at the byte at offset (end() for size())
+   */
+  [[nodiscard]] auto at(usize offset) const -> typename Chars::const_iterator;
+
+  Chars chars_{};
+};
+
+#ifndef LARIAT_TEXT_CPP
+  #include "lariat_text.cpp"
+#endif
+
+#endif // LARIAT_TEXT_H
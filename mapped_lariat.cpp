@@ -0,0 +1,128 @@
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAPPED_LARIAT_CPP
+
+#ifndef MAPPED_LARIAT_H
+  #include "mapped_lariat.h"
+#endif
+
+template<typename T, usize Size>
+MappedLariat<T, Size>::MappedLariat() {}
+
+template<typename T, usize Size>
+MappedLariat<T, Size>::MappedLariat(const std::string& path) {
+  open(path);
+}
+
+template<typename T, usize Size>
+MappedLariat<T, Size>::~MappedLariat() {
+  close();
+}
+
+template<typename T, usize Size>
+auto MappedLariat<T, Size>::open(const std::string& path) -> void {
+  close();
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      "Cannot open " + path + ": " + std::strerror(errno)
+    };
+  }
+
+  struct stat info{};
+  if (::fstat(fd_, &info) != 0) {
+    close();
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      "Cannot stat " + path + ": " + std::strerror(errno)
+    };
+  }
+
+  try {
+    if (info.st_size == 0) {
+      if (::ftruncate(fd_, static_cast<off_t>(Base::header_bytes)) != 0) {
+        throw LariatException{
+          LariatException::E_DATA_ERROR,
+          "Cannot size " + path + ": " + std::strerror(errno)
+        };
+      }
+      map(Base::header_bytes);
+      this->init_header();
+      return;
+    }
+
+    if (static_cast<usize>(info.st_size) < Base::header_bytes) {
+      throw LariatException{
+        LariatException::E_DATA_ERROR,
+        path + " is not a mapped Lariat"
+      };
+    }
+    map(static_cast<usize>(info.st_size));
+    this->check_header(path);
+    this->check_links(path);
+  } catch (...) {
+    close();
+    throw;
+  }
+}
+
+template<typename T, usize Size>
+auto MappedLariat<T, Size>::sync() -> void {
+  this->require_open();
+
+  if (::msync(this->base_, this->bytes_, MS_SYNC) != 0) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      std::string{"msync failed: "} + std::strerror(errno)
+    };
+  }
+}
+
+template<typename T, usize Size>
+auto MappedLariat<T, Size>::close() -> void {
+  if (this->base_) {
+    ::munmap(this->base_, this->bytes_);
+    this->base_ = nullptr;
+    this->bytes_ = 0;
+  }
+
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+template<typename T, usize Size>
+auto MappedLariat<T, Size>::resize_region(const usize bytes) -> void {
+  if (::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+    throw LariatException{LariatException::E_NO_MEMORY};
+  }
+
+  ::munmap(this->base_, this->bytes_);
+  this->base_ = nullptr;
+  map(bytes);
+}
+
+template<typename T, usize Size>
+auto MappedLariat<T, Size>::map(const usize bytes) -> void {
+  void* const mapping =
+    ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+
+  if (mapping == MAP_FAILED) {
+    throw LariatException{
+      LariatException::E_DATA_ERROR,
+      std::string{"mmap failed: "} + std::strerror(errno)
+    };
+  }
+
+  this->base_ = static_cast<char*>(mapping);
+  this->bytes_ = bytes;
+}
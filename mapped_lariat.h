@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+#ifndef MAPPED_LARIAT_H
+#define MAPPED_LARIAT_H
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lariat_pages.h"
+
+#include <string>
+
+/**
+ * @brief Lariat whose nodes live in a memory mapped file
+ *
+ * The file is the LariatPages region: pages link to each other by page
+ * number, so the file can be mapped at any address and reopened without
+ * deserializing. The OS page cache does the paging, which allows lists larger
+ * than RAM.
+ */
+template<typename T, usize Size>
+class MappedLariat : public LariatPages<T, Size, MappedLariat<T, Size>> {
+public:
+
+  /**
+   * @brief Creates a closed list, call open before using it
+   */
+  MappedLariat();
+
+  /**
+   * @brief Opens (or creates) the list stored at path
+   */
+  explicit MappedLariat(const std::string& path);
+
+  MappedLariat(const MappedLariat&) = delete;
+
+  MappedLariat(MappedLariat&&) = delete;
+
+  /**
+   * @brief Destructor, unmaps the file
+   */
+  ~MappedLariat();
+
+  auto operator=(const MappedLariat&) -> MappedLariat& = delete;
+
+  auto operator=(MappedLariat&&) -> MappedLariat& = delete;
+
+  /**
+   * @brief Maps the file at path, creating an empty list if it does not exist
+   *
+   * The page links of an existing file are walked once before it is used.
+   *
+   * @throws LariatException E_DATA_ERROR if the file cannot be mapped, is
+   * malformed (see ArenaLariat::load) or holds a list of another element type
+   * or node size, the list is left closed
+   */
+  auto open(const std::string& path) -> void;
+
+  /**
+   * @brief Flushes dirty pages to the file
+   */
+  auto sync() -> void;
+
+  /**
+   * @brief Unmaps the file, the list is kept on disk
+   */
+  auto close() -> void;
+
+private:
+
+  using Base = LariatPages<T, Size, MappedLariat<T, Size>>;
+
+  friend Base;
+
+  /**
+   * @brief Resizes the file to the given number of bytes and remaps it
+   */
+  auto resize_region(usize bytes) -> void;
+
+  /**
+   * @brief Maps the first bytes of the open file
+   */
+  auto map(usize bytes) -> void;
+
+  /**
+   * @brief File descriptor of the backing file, -1 when closed
+   */
+  int fd_{-1};
+};
+
+#ifndef MAPPED_LARIAT_CPP
+  #include "mapped_lariat.cpp"
+#endif
+
+#endif // MAPPED_LARIAT_H
@@ -0,0 +1,429 @@
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LARIAT_SCENARIO_H
+#define LARIAT_SCENARIO_H
+////////////////////////////////////////////////////////////////////////////////
+
+// Random operation scenarios for stress testing and benchmarking Lariat.
+//
+// A scenario is generated up front into a flat array of (Action, position,
+// value) records, so replaying it costs nothing but the operations. The
+// generator is a std::mt19937 seeded explicitly, and draws only through
+// integer arithmetic on its raw output (no std:: distributions, whose results
+// differ between standard libraries), so a seed names the same sequence
+// everywhere. Scenarios can be written to and read back from a binary trace.
+
+#include "lariat.h"
+
+#include <algorithm>  // std::max_element
+#include <functional> // std::bind std::placeholders
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+enum Action {
+  Insert,
+  Pushback,
+  Pushfront,
+  Compact,
+  Erase,
+  Popback,
+  Popfront,
+  Index,
+  Find
+};
+
+//            <------- always OK ---------------->  <-- when non-empty ---->
+
+/**
+ * @brief Number of values in Action
+ */
+constexpr u32 action_count = 9;
+
+/**
+ * @brief Seeded source of the integers a scenario is drawn from
+ */
+class RandomNumber {
+public:
+
+  explicit RandomNumber(u32 seed): gen(seed) {}
+
+  /**
+   * @brief Returns 0..max-1 inclusively
+   */
+  u32 GetInt(u32 max) {
+    return static_cast<u32>((static_cast<u64>(gen()) * max) >> 32);
+  }
+
+  /**
+   * @brief Returns a float in [0, 1)
+   */
+  float GetUnit() {
+    return static_cast<float>(gen() >> 8) * (1.0f / 16777216.0f);
+  }
+
+private:
+
+  std::mt19937 gen;
+};
+
+/**
+ * @brief Picks actions with given relative frequencies in O(1) per spin
+ * (Vose's alias method)
+ *
+ * Every slot of a flat table holds a probability and an alias, a spin picks a
+ * slot uniformly then flips a biased coin between the slot and its alias.
+ */
+class RouletteWheel {
+public:
+
+  explicit RouletteWheel(const std::vector<float>& weights):
+      prob(weights.size()), alias(weights.size()) {
+    const usize n = weights.size();
+    float total = 0;
+    for (const float w: weights) {
+      total += w;
+    }
+
+    // scaled so that the average slot holds exactly 1
+    std::vector<float> scaled(n);
+    std::vector<u32> small, large;
+    for (usize i = 0; i < n; ++i) {
+      scaled[i] = weights[i] * static_cast<float>(n) / total;
+      (scaled[i] < 1.0f ? small : large).push_back(static_cast<u32>(i));
+    }
+
+    while (not small.empty() and not large.empty()) {
+      const u32 s = small.back();
+      const u32 l = large.back();
+      small.pop_back();
+      large.pop_back();
+
+      prob[s] = scaled[s];
+      alias[s] = l;
+      scaled[l] -= 1.0f - scaled[s];
+      (scaled[l] < 1.0f ? small : large).push_back(l);
+    }
+
+    // leftovers are 1 up to rounding
+    for (const u32 i: small) {
+      prob[i] = 1.0f;
+      alias[i] = i;
+    }
+    for (const u32 i: large) {
+      prob[i] = 1.0f;
+      alias[i] = i;
+    }
+  }
+
+  u32 Spin(RandomNumber& rn) const {
+    const u32 slot = rn.GetInt(static_cast<u32>(prob.size()));
+    return rn.GetUnit() < prob[slot] ? slot : alias[slot];
+  }
+
+private:
+
+  std::vector<float> prob;
+  std::vector<u32> alias;
+};
+
+/**
+ * @brief Header of a binary scenario trace, followed by count records of
+ * (u8 action, i32 position, i32 value) in host byte order
+ */
+struct LariatTraceHeader {
+  char magic[4];
+  u32 version;
+  u64 seed;
+  u64 count;
+};
+
+class LariatScenario {
+public:
+
+  LariatScenario() = delete;
+  LariatScenario(const LariatScenario&) = delete;
+  LariatScenario(LariatScenario&&) = delete;
+  LariatScenario& operator=(const LariatScenario&) = delete;
+  LariatScenario& operator=(LariatScenario&&) = delete;
+  ~LariatScenario() = default;
+
+  /**
+   * @brief Layout version of the binary trace
+   */
+  static constexpr u32 trace_version = 1;
+
+  /**
+   * @brief A fresh seed for runs that do not need to be reproduced
+   */
+  static u32 RandomSeed() { return std::random_device{}(); }
+
+  LariatScenario(
+    int num_operations,
+    int max_value,
+    float insertF,
+    float eraseF,     // relative frequences of the 9 operations
+    float pushbackF,
+    float pushfrontF, // do not have to add up to 1
+    float popbackF,
+    float popfrontF,  // normalized by hand
+    float compactF,
+    float indexF,
+    float findF,
+    u32 _seed = RandomSeed()
+  ):
+      seed(_seed) {
+    u32 current_size =
+      0; // need to know whether delete-like operations are allowed
+
+    // indexed by Action
+    const std::vector<float> all = {
+      insertF,
+      pushbackF,
+      pushfrontF,
+      compactF,
+      eraseF,
+      popbackF,
+      popfrontF,
+      indexF,
+      findF
+    };
+    RouletteWheel rw_all(all
+    ); // roulette wheel with required frequencies for all actions
+    RouletteWheel rw_insert({insertF, pushbackF, pushfrontF, compactF}
+    ); // roulette wheel with required frequencies for insert-like actions
+
+    RandomNumber rn(seed);
+    const u32 max_val = static_cast<u32>(max_value);
+
+    scenario.reserve(static_cast<usize>(num_operations));
+    for (int i = 0; i < num_operations; ++i) {
+      Action action;
+      if (current_size == 0) { // only insert, pushes, compact are allowed
+        action = static_cast<Action>(rw_insert.Spin(rn));
+      } else {
+        action = static_cast<Action>(rw_all.Spin(rn));
+      }
+
+      int pos = 0; // position not used by operation
+      int val = 0; // value not used by operation
+      if (action == Insert) { // insert is legal at indicies 0..current_size
+                              // inclusively
+        pos = static_cast<int>(rn.GetInt(current_size + 1));
+        val = static_cast<int>(rn.GetInt(max_val));
+        ++current_size;
+      } else if (action == Erase) { // erase is legal at indicies
+                                    // 0..current_size-1 inclusively
+        pos = static_cast<int>(rn.GetInt(current_size));
+        --current_size;
+      } else if (action == Pushfront || action == Pushback) {
+        val = static_cast<int>(rn.GetInt(100));
+        ++current_size;
+      } else if (action == Popfront || action == Popback) {
+        --current_size;
+      } else if (action == Find) {
+        val = static_cast<int>(rn.GetInt(100));
+      } else if (action == Index) {
+        pos = static_cast<int>(rn.GetInt(current_size));
+      }
+      scenario.push_back(std::tuple<Action, int, int>(action, pos, val));
+    }
+  }
+
+  /**
+   * @brief Reads a scenario recorded with WriteTrace
+   *
+   * @throws LariatException E_DATA_ERROR if the stream does not hold a trace
+   */
+  explicit LariatScenario(std::istream& trace) { ReadTrace(trace); }
+
+  /**
+   * @brief Writes the scenario as a binary trace
+   */
+  void WriteTrace(std::ostream& os) const {
+    const LariatTraceHeader header{
+      {'L', 'T', 'R', 'C'},
+      trace_version,
+      seed,
+      scenario.size()
+    };
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& op: scenario) {
+      const u8 a = static_cast<u8>(std::get<0>(op));
+      const i32 pos = std::get<1>(op);
+      const i32 val = std::get<2>(op);
+      os.write(reinterpret_cast<const char*>(&a), sizeof(a));
+      os.write(reinterpret_cast<const char*>(&pos), sizeof(pos));
+      os.write(reinterpret_cast<const char*>(&val), sizeof(val));
+    }
+  }
+
+  /**
+   * @brief Replaces the scenario with one read from a binary trace
+   *
+   * @throws LariatException E_DATA_ERROR if the stream does not hold a trace
+   */
+  void ReadTrace(std::istream& is) {
+    scenario.clear();
+
+    LariatTraceHeader header{};
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (not is or std::memcmp(header.magic, "LTRC", sizeof(header.magic)) != 0
+        or header.version != trace_version) {
+      throw LariatException{
+        LariatException::E_DATA_ERROR,
+        "Not a Lariat scenario trace"
+      };
+    }
+    seed = static_cast<u32>(header.seed);
+
+    for (u64 i = 0; i < header.count; ++i) {
+      u8 a = 0;
+      i32 pos = 0;
+      i32 val = 0;
+      is.read(reinterpret_cast<char*>(&a), sizeof(a));
+      is.read(reinterpret_cast<char*>(&pos), sizeof(pos));
+      is.read(reinterpret_cast<char*>(&val), sizeof(val));
+      if (not is or a >= action_count) {
+        scenario.clear();
+        throw LariatException{
+          LariatException::E_DATA_ERROR,
+          "Truncated Lariat scenario trace"
+        };
+      }
+      scenario.push_back(
+        std::tuple<Action, int, int>(static_cast<Action>(a), pos, val)
+      );
+    }
+  }
+
+  /**
+   * @brief Seed the scenario was generated from
+   */
+  u32 Seed() const { return seed; }
+
+  friend std::ostream& operator<<(std::ostream& os, const LariatScenario& sc) {
+    for (const auto& op: sc.Get()) {
+      int val = std::get<2>(op);
+      int pos = std::get<1>(op);
+      Action a = std::get<0>(op);
+      switch (a) { // use labels
+        case Insert: os << "Insert"; break;
+        case Erase: os << "Erase"; break;
+        case Pushback: os << "Pushback"; break;
+        case Pushfront: os << "Pushfront"; break;
+        case Popfront: os << "Popfront"; break;
+        case Popback: os << "Popback"; break;
+        case Compact: os << "Compact"; break;
+        case Index: os << "Index"; break;
+        case Find: os << "Find"; break;
+      }
+      os << " " << pos << " " << val << std::endl;
+    }
+    return os;
+  }
+
+  friend std::istream& operator>>(std::istream& is, LariatScenario& sc) {
+    sc.scenario.erase(sc.scenario.begin(), sc.scenario.end());
+    for (std::string a_str; is >> a_str;) {
+      int pos = 0, val = 0;
+      Action a;
+      if (a_str == "Insert") {
+        a = Insert;
+        is >> pos >> val;
+      } else if (a_str == "Erase") {
+        a = Erase;
+        is >> pos;
+      } else if (a_str == "Pushback") {
+        a = Pushback;
+        is >> val;
+      } else if (a_str == "Pushfront") {
+        a = Pushfront;
+        is >> val;
+      } else if (a_str == "Popfront") {
+        a = Popfront;
+      } else if (a_str == "Popback") {
+        a = Popback;
+      } else if (a_str == "Compact") {
+        a = Compact;
+      } else if (a_str == "Index") {
+        a = Index;
+        is >> pos;
+      } else if (a_str == "Find") {
+        a = Find;
+        is >> val;
+      } else {
+        // add NOOP?
+      }
+      sc.scenario.push_back(std::tuple<Action, int, int>(a, pos, val));
+    }
+    return is;
+  }
+
+  ////////////////////////////////////////////////////
+  const std::vector<std::tuple<Action, int, int>>& Get() const {
+    return scenario;
+  }
+
+  void DrawStats(std::map<Action, std::string>& labels
+  ) const // reference should be const, but std::map[] is complaining
+  {
+    // final frequencies
+    std::map<Action, float> counts;
+    for (const auto& op: scenario) {
+      Action a = std::get<0>(op);
+      counts[a] += 1.0f;
+    }
+
+    // normalization - longest label
+    unsigned max_len = 0;
+    for (const auto& lbl: labels) {
+      if (lbl.second.length() > max_len) {
+        max_len = static_cast<unsigned>(lbl.second.length());
+      }
+    }
+
+    // normalization 80 symbols
+    float max_freq = std::max_element(
+                       counts.begin(),
+                       counts.end(),
+                       std::bind(
+                         std::less<float>(),
+                         bind(
+                           &std::map<Action, float>::value_type::second,
+                           std::placeholders::_1
+                         ),
+                         bind(
+                           &std::map<Action, float>::value_type::second,
+                           std::placeholders::_2
+                         )
+                       )
+    )
+                       ->second;
+
+    max_len += 1; // bar offset
+    // print
+    std::cout << "Statistics\n";
+    for (const auto& el: counts) {
+      std::cout << std::left << std::setw(static_cast<int>(max_len))
+                << labels[el.first] << std::setfill('+')
+                << std::setw(static_cast<int>(
+                     el.second / max_freq * static_cast<float>(79 - max_len)
+                   ))
+                << "+" << std::setfill(' ')
+                << std::endl; // should have saved fill from before and set it
+                              // back, assume 'space'
+    }
+  }
+
+private:
+
+  std::vector<std::tuple<Action, int, int>> scenario; // action, position, value
+  u32 seed{0};
+};
+
+#endif // LARIAT_SCENARIO_H